@@ -0,0 +1,129 @@
+#include "adaptivesampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+
+// One background grid per radius octave: level k holds samples with radius
+// in [rMin * 2^k, rMin * 2^(k+1)), with cells small enough to hold at most
+// one of them.
+struct GridLevel{
+    float cellSize;
+    float maxRadius;
+    int nx, ny;
+    vector<int> cells;
+};
+
+class MultiLevelGrid{
+    private:
+        array<float, 2> origin;
+        float rMin;
+        vector<GridLevel> levels;
+    public:
+        MultiLevelGrid(array<float, 2> lo, array<float, 2> hi, float minRadius, float maxRadius):
+            origin(lo), rMin(minRadius){
+            int count = 1 + max(0, (int)floor(log2(maxRadius / minRadius)));
+            for (int k = 0; k < count; k++){
+                GridLevel level;
+                float r = rMin * ldexp(1.0f, k);
+                level.cellSize = r / sqrt(2.0f);
+                level.maxRadius = 2.0f * r;
+                level.nx = max(1, (int)ceil((hi[0] - lo[0]) / level.cellSize));
+                level.ny = max(1, (int)ceil((hi[1] - lo[1]) / level.cellSize));
+                level.cells.assign(level.nx * level.ny, -1);
+                levels.push_back(level);
+            }
+        }
+        int levelFor(float r){
+            int k = (int)floor(log2(r / rMin));
+            return min(max(k, 0), (int)levels.size() - 1);
+        }
+        void insert(int idx, float x, float y, float r){
+            GridLevel& level = levels[levelFor(r)];
+            int i = min(max((int)((x - origin[0]) / level.cellSize), 0), level.nx - 1);
+            int j = min(max((int)((y - origin[1]) / level.cellSize), 0), level.ny - 1);
+            level.cells[j * level.nx + i] = idx;
+        }
+        bool conflicts(float x, float y, float r, const vector<array<float, 2>>& samples, const vector<float>& radii){
+            for (GridLevel& level : levels){
+                // nothing stored at this level can need more than its own
+                // octave's radius, which keeps the window a few cells wide
+                float reach = min(r, level.maxRadius);
+                int i0 = max((int)((x - reach - origin[0]) / level.cellSize), 0);
+                int i1 = min((int)((x + reach - origin[0]) / level.cellSize), level.nx - 1);
+                int j0 = max((int)((y - reach - origin[1]) / level.cellSize), 0);
+                int j1 = min((int)((y + reach - origin[1]) / level.cellSize), level.ny - 1);
+                for (int j = j0; j <= j1; j++){
+                    for (int i = i0; i <= i1; i++){
+                        int idx = level.cells[j * level.nx + i];
+                        if (idx < 0) continue;
+                        float dx = samples[idx][0] - x, dy = samples[idx][1] - y;
+                        float d = min(r, radii[idx]);
+                        if (dx * dx + dy * dy < d * d) return true;
+                    }
+                }
+            }
+            return false;
+        }
+};
+
+}
+
+vector<array<float, 2>> adaptivePoissonSampling(const AdaptiveSamplerParams& params,
+                                                const DensityFunction& density,
+                                                array<float, 2> xmin,
+                                                array<float, 2> xmax,
+                                                CounterRng& rng){
+    vector<array<float, 2>> samples;
+    vector<float> radii;
+    if (xmax[0] <= xmin[0] || xmax[1] <= xmin[1] || params.baseRadius <= 0.0f) return samples;
+
+    float minScale = min(params.minScale, params.maxScale);
+    float maxScale = max(params.minScale, params.maxScale);
+    auto radiusAt = [&](float x, float y){
+        float s = density ? density(x, y) : 1.0f;
+        return params.baseRadius * min(max(s, minScale), maxScale);
+    };
+    MultiLevelGrid grid(xmin, xmax, params.baseRadius * minScale, params.baseRadius * maxScale);
+
+    vector<int> active;
+    auto add = [&](float x, float y, float r){
+        int idx = (int)samples.size();
+        samples.push_back({x, y});
+        radii.push_back(r);
+        grid.insert(idx, x, y, r);
+        active.push_back(idx);
+    };
+    float x0 = rng.nextRange(xmin[0], xmax[0]);
+    float y0 = rng.nextRange(xmin[1], xmax[1]);
+    add(x0, y0, radiusAt(x0, y0));
+
+    while (!active.empty()){
+        size_t pick = min((size_t)(rng.nextFloat() * active.size()), active.size() - 1);
+        int idx = active[pick];
+        float r = radii[idx];
+        bool found = false;
+        for (int a = 0; a < params.attempts; a++){
+            // uniform by area over the annulus [r, 2r]
+            float angle = rng.nextFloat() * 2.0f * (float)M_PI;
+            float dist = r * sqrt(1.0f + 3.0f * rng.nextFloat());
+            float x = samples[idx][0] + dist * cos(angle);
+            float y = samples[idx][1] + dist * sin(angle);
+            if (x < xmin[0] || x > xmax[0] || y < xmin[1] || y > xmax[1]) continue;
+            float rc = radiusAt(x, y);
+            if (!grid.conflicts(x, y, rc, samples, radii)){
+                add(x, y, rc);
+                found = true;
+                break;
+            }
+        }
+        if (!found){
+            active[pick] = active.back();
+            active.pop_back();
+        }
+    }
+    return samples;
+}
@@ -0,0 +1,31 @@
+#ifndef ADAPTIVE_SAMPLER_H
+#define ADAPTIVE_SAMPLER_H
+
+#include <array>
+#include <functional>
+#include <vector>
+
+#include "rng.h"
+
+// Spacing multiplier at (x, y): 1 keeps the base radius, < 1 packs samples
+// closer together, > 1 spreads them out.
+typedef std::function<float(float, float)> DensityFunction;
+
+struct AdaptiveSamplerParams{
+    float baseRadius;
+    float minScale = 1.0f; // density is clamped to [minScale, maxScale]
+    float maxScale = 1.0f;
+    int attempts = 30;
+};
+
+// Variable-radius Poisson disk sampling (Bridson's algorithm). Two samples
+// conflict when closer than the smaller of their radii. Samples are binned
+// into a grid level per radius octave, so every neighbour check visits a
+// bounded number of cells per level however much the radius varies.
+std::vector<std::array<float, 2>> adaptivePoissonSampling(const AdaptiveSamplerParams& params,
+                                                          const DensityFunction& density,
+                                                          std::array<float, 2> xmin,
+                                                          std::array<float, 2> xmax,
+                                                          CounterRng& rng);
+
+#endif
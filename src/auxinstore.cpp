@@ -0,0 +1,83 @@
+#include "auxinstore.h"
+
+using namespace std;
+
+static const uint32_t FREE_SLOT = UINT32_MAX;
+
+AuxinHandle AuxinStore::insert(float x, float y, uint32_t step, VeinNode* near, float dist){
+    uint32_t slot;
+    if (!freeSlots.empty()){
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else {
+        slot = static_cast<uint32_t>(slotToDense.size());
+        slotToDense.push_back(0);
+        slotGeneration.push_back(0);
+    }
+    slotToDense[slot] = static_cast<uint32_t>(size());
+    pos.push_back(x);
+    pos.push_back(y);
+    birthStep.push_back(step);
+    nearest.push_back(near);
+    nearestDist.push_back(dist);
+    denseToSlot.push_back(slot);
+    return {slot, slotGeneration[slot]};
+}
+
+void AuxinStore::removeAt(size_t i){
+    size_t last = size() - 1;
+    uint32_t slot = denseToSlot[i];
+    if (i != last){
+        pos[2 * i] = pos[2 * last];
+        pos[2 * i + 1] = pos[2 * last + 1];
+        birthStep[i] = birthStep[last];
+        nearest[i] = nearest[last];
+        nearestDist[i] = nearestDist[last];
+        denseToSlot[i] = denseToSlot[last];
+        slotToDense[denseToSlot[i]] = static_cast<uint32_t>(i);
+    }
+    pos.resize(2 * last);
+    birthStep.pop_back();
+    nearest.pop_back();
+    nearestDist.pop_back();
+    denseToSlot.pop_back();
+    slotToDense[slot] = FREE_SLOT;
+    slotGeneration[slot]++;
+    freeSlots.push_back(slot);
+}
+
+bool AuxinStore::remove(AuxinHandle h){
+    long i = indexOf(h);
+    if (i < 0) return false;
+    removeAt(static_cast<size_t>(i));
+    return true;
+}
+
+bool AuxinStore::isValid(AuxinHandle h){
+    return h.slot < slotGeneration.size() && slotGeneration[h.slot] == h.generation
+        && slotToDense[h.slot] != FREE_SLOT;
+}
+
+long AuxinStore::indexOf(AuxinHandle h){
+    if (!isValid(h)) return -1;
+    return static_cast<long>(slotToDense[h.slot]);
+}
+
+AuxinHandle AuxinStore::handleAt(size_t i){
+    uint32_t slot = denseToSlot[i];
+    return {slot, slotGeneration[slot]};
+}
+
+void AuxinStore::clear(){
+    for (uint32_t slot : denseToSlot){
+        slotToDense[slot] = FREE_SLOT;
+        slotGeneration[slot]++;
+        freeSlots.push_back(slot);
+    }
+    pos.clear();
+    birthStep.clear();
+    nearest.clear();
+    nearestDist.clear();
+    denseToSlot.clear();
+}
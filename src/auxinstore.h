@@ -0,0 +1,72 @@
+#ifndef AUXIN_STORE_H
+#define AUXIN_STORE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+class VeinNode;
+
+// Stable reference to an auxin source. A handle goes stale as soon as its
+// source is removed, even if the slot is later reused.
+struct AuxinHandle{
+    uint32_t slot;
+    uint32_t generation;
+};
+
+// Live auxin sources kept densely packed in parallel arrays. Removal swaps
+// the last source into the hole, so dense indices are only valid until the
+// next removal; use handles to refer to a source across edits.
+class AuxinStore{
+    private:
+        std::vector<float> pos; // x, y pairs: uploaded to the GPU as-is
+        std::vector<uint32_t> birthStep;
+        std::vector<VeinNode*> nearest;
+        std::vector<float> nearestDist;
+        std::vector<uint32_t> denseToSlot;
+        std::vector<uint32_t> slotToDense;
+        std::vector<uint32_t> slotGeneration;
+        std::vector<uint32_t> freeSlots;
+    public:
+        AuxinHandle insert(float x, float y, uint32_t step, VeinNode* near = nullptr, float dist = 0.0f);
+        bool remove(AuxinHandle h);
+        void removeAt(size_t i);
+        bool isValid(AuxinHandle h);
+        long indexOf(AuxinHandle h); // -1 if stale
+        AuxinHandle handleAt(size_t i);
+        void clear();
+        size_t size(){
+            return birthStep.size();
+        }
+        bool empty(){
+            return birthStep.empty();
+        }
+        float getX(size_t i){
+            return pos[2 * i];
+        }
+        float getY(size_t i){
+            return pos[2 * i + 1];
+        }
+        uint32_t getBirthStep(size_t i){
+            return birthStep[i];
+        }
+        VeinNode* getNearest(size_t i){
+            return nearest[i];
+        }
+        float getNearestDist(size_t i){
+            return nearestDist[i];
+        }
+        void setNearest(size_t i, VeinNode* node, float dist){
+            nearest[i] = node;
+            nearestDist[i] = dist;
+        }
+        const float* positionData(){
+            return pos.data();
+        }
+        // for passes that move every source at once
+        float* writablePositionData(){
+            return pos.data();
+        }
+};
+
+#endif
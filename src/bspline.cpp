@@ -0,0 +1,86 @@
+#include "bspline.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+#define SPLINE_SWEEPS 48
+#define SPLINE_NEWTON_STEPS 4
+
+// span and local parameter of t, with the four control indices
+static float spanOf(size_t n, float t, size_t c[4]){
+    float f = floor(t);
+    float u = t - f;
+    long i = (long)f % (long)n;
+    if (i < 0) i += (long)n;
+    c[0] = ((size_t)i + n - 1) % n;
+    c[1] = (size_t)i;
+    c[2] = ((size_t)i + 1) % n;
+    c[3] = ((size_t)i + 2) % n;
+    return u;
+}
+
+static float combine(const float* p, const size_t c[4], const float b[4]){
+    return b[0] * p[c[0]] + b[1] * p[c[1]] + b[2] * p[c[2]] + b[3] * p[c[3]];
+}
+
+void splinePoint(const float* px, const float* py, size_t n, float t, float& x, float& y){
+    size_t c[4];
+    float u = spanOf(n, t, c), s = 1.0f - u, u2 = u * u, u3 = u2 * u;
+    float b[4] = {s * s * s / 6.0f, (3.0f * u3 - 6.0f * u2 + 4.0f) / 6.0f,
+                  (-3.0f * u3 + 3.0f * u2 + 3.0f * u + 1.0f) / 6.0f, u3 / 6.0f};
+    x = combine(px, c, b);
+    y = combine(py, c, b);
+}
+
+void splineTangent(const float* px, const float* py, size_t n, float t, float& dx, float& dy){
+    size_t c[4];
+    float u = spanOf(n, t, c), s = 1.0f - u, u2 = u * u;
+    float b[4] = {-0.5f * s * s, 0.5f * (3.0f * u2 - 4.0f * u), 0.5f * (-3.0f * u2 + 2.0f * u + 1.0f), 0.5f * u2};
+    dx = combine(px, c, b);
+    dy = combine(py, c, b);
+}
+
+static void splineCurvature(const float* px, const float* py, size_t n, float t, float& ddx, float& ddy){
+    size_t c[4];
+    float u = spanOf(n, t, c);
+    float b[4] = {1.0f - u, 3.0f * u - 2.0f, 1.0f - 3.0f * u, u};
+    ddx = combine(px, c, b);
+    ddy = combine(py, c, b);
+}
+
+void splineInterpolate(const float* qx, const float* qy, size_t n, float* px, float* py){
+    if (n < 3) return;
+    vector<float> x(qx, qx + n), y(qy, qy + n), nx(n), ny(n);
+    for (int sweep = 0; sweep < SPLINE_SWEEPS; sweep++){
+        for (size_t i = 0; i < n; i++){
+            size_t h = i == 0 ? n - 1 : i - 1, j = i + 1 == n ? 0 : i + 1;
+            nx[i] = 1.5f * qx[i] - 0.25f * (x[h] + x[j]);
+            ny[i] = 1.5f * qy[i] - 0.25f * (y[h] + y[j]);
+        }
+        x.swap(nx);
+        y.swap(ny);
+    }
+    copy(x.begin(), x.end(), px);
+    copy(y.begin(), y.end(), py);
+}
+
+float splineProject(const float* px, const float* py, size_t n, float t, float qx, float qy, float reach){
+    float start = t;
+    for (int k = 0; k < SPLINE_NEWTON_STEPS; k++){
+        float x, y, dx, dy, ddx, ddy;
+        splinePoint(px, py, n, t, x, y);
+        splineTangent(px, py, n, t, dx, dy);
+        splineCurvature(px, py, n, t, ddx, ddy);
+        float ex = x - qx, ey = y - qy;
+        float f = ex * dx + ey * dy;
+        float df = dx * dx + dy * dy + ex * ddx + ey * ddy;
+        if (df <= 0.0f) break; // not near a minimum; keep what we have
+        t = min(max(t - f / df, start - reach), start + reach);
+    }
+    float wrapped = fmod(t, (float)n);
+    if (wrapped < 0.0f) wrapped += (float)n;
+    return wrapped < (float)n ? wrapped : 0.0f;
+}
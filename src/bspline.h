@@ -0,0 +1,25 @@
+#ifndef BSPLINE_H
+#define BSPLINE_H
+
+#include <cstddef>
+
+// Closed uniform cubic B-splines over n control points px, py. The curve
+// parameter t runs over [0, n), span i covering [i, i + 1) and shaped by
+// controls i - 1 to i + 2, wrapping round. Points, tangents and second
+// derivatives are all closed form.
+
+// point at t
+void splinePoint(const float* px, const float* py, size_t n, float t, float& x, float& y);
+// first derivative at t; the outward normal of a counter-clockwise curve
+// is (dy, -dx) normalised
+void splineTangent(const float* px, const float* py, size_t n, float t, float& dx, float& dy);
+// Controls for the curve passing through (qx[i], qy[i]) at t = i, found by
+// solving the periodic (1 4 1) / 6 system with Jacobi sweeps: it is
+// diagonally dominant, so each sweep halves the error.
+void splineInterpolate(const float* qx, const float* qy, size_t n, float* px, float* py);
+// Starting from t, the parameter of the curve point closest to (qx, qy),
+// by a few Newton steps on (C(t) - q) . C'(t) = 0 limited to `reach`
+// either way; the result is wrapped into [0, n).
+float splineProject(const float* px, const float* py, size_t n, float t, float qx, float qy, float reach);
+
+#endif
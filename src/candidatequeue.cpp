@@ -0,0 +1,58 @@
+#include "candidatequeue.h"
+
+#include <chrono>
+
+using namespace std;
+
+size_t CandidateQueue::process(uint64_t step, const function<void(const SourceCandidate&)>& admit){
+    auto start = chrono::steady_clock::now();
+    size_t count = 0;
+    while (!pending.empty()){
+        if (maxCandidates > 0 && count >= maxCandidates) break;
+        if (maxMillis > 0.0 && count > 0){
+            chrono::duration<double, milli> spent = chrono::steady_clock::now() - start;
+            if (spent.count() >= maxMillis) break;
+        }
+        SourceCandidate c = pending.top();
+        pending.pop();
+        if (maxAge > 0 && step - c.step > maxAge){
+            dropped++;
+            continue;
+        }
+        admit(c);
+        count++;
+    }
+    lastProcessed = count;
+    return count;
+}
+
+void CandidateQueue::clear(){
+    pending = {};
+    lastProcessed = 0;
+}
+
+void CandidateQueue::scaleAbout(float cx, float cy, float factor){
+    for (SourceCandidate& c : pending.items()){
+        c.x = cx + factor * (c.x - cx);
+        c.y = cy + factor * (c.y - cy);
+    }
+}
+
+vector<SourceCandidate> CandidateQueue::contents() const {
+    auto copy = pending;
+    vector<SourceCandidate> out;
+    out.reserve(copy.size());
+    while (!copy.empty()){
+        out.push_back(copy.top());
+        copy.pop();
+    }
+    return out;
+}
+
+void CandidateQueue::restore(const vector<SourceCandidate>& candidates, unsigned long droppedCount){
+    clear();
+    for (const SourceCandidate& c : candidates){
+        pending.push(c);
+    }
+    dropped = droppedCount;
+}
\ No newline at end of file
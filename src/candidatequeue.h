@@ -0,0 +1,71 @@
+#ifndef CANDIDATE_QUEUE_H
+#define CANDIDATE_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+struct SourceCandidate{
+    float x;
+    float y;
+    uint64_t step;  // step the candidate was sampled in
+    uint32_t order; // position within that step's batch
+};
+
+// Sampled auxin candidates waiting for the (expensive) nearest-node and
+// spacing checks. Each step drains at most maxCandidates of them and/or
+// stops after maxMillis; the rest carry over, oldest first. A zero limit
+// means unlimited. The count limit is deterministic, the time limit is not.
+class CandidateQueue{
+    private:
+        struct Newer{
+            bool operator()(const SourceCandidate& a, const SourceCandidate& b) const {
+                return a.step != b.step ? a.step > b.step : a.order > b.order;
+            }
+        };
+        // the heap's order only depends on step and order, so positions
+        // can be edited in place
+        struct Heap: std::priority_queue<SourceCandidate, std::vector<SourceCandidate>, Newer>{
+            std::vector<SourceCandidate>& items(){
+                return c;
+            }
+        };
+        Heap pending;
+        size_t maxCandidates = 0;
+        double maxMillis = 0.0;
+        uint64_t maxAge = 0; // candidates older than this many steps are dropped
+        size_t lastProcessed = 0;
+        unsigned long dropped = 0;
+    public:
+        void push(const SourceCandidate& c){
+            pending.push(c);
+        }
+        // hands candidates to `admit` until the budget runs out
+        size_t process(uint64_t step, const std::function<void(const SourceCandidate&)>& admit);
+        void clear();
+        // moves every pending candidate by `factor` about (cx, cy)
+        void scaleAbout(float cx, float cy, float factor);
+        // pending candidates in processing order, for checkpoints
+        std::vector<SourceCandidate> contents() const;
+        void restore(const std::vector<SourceCandidate>& candidates, unsigned long droppedCount);
+        void setBudget(size_t candidates, double millis){
+            maxCandidates = candidates;
+            maxMillis = millis;
+        }
+        void setMaxAge(uint64_t steps){
+            maxAge = steps;
+        }
+        size_t size(){
+            return pending.size();
+        }
+        size_t getLastProcessed(){
+            return lastProcessed;
+        }
+        unsigned long getDropped(){
+            return dropped;
+        }
+};
+
+#endif
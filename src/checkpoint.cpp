@@ -0,0 +1,365 @@
+#include "checkpoint.h"
+
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char CHECKPOINT_MAGIC[8] = {'L', 'E', 'A', 'F', 'C', 'K', 'P', 'T'};
+static const uint32_t ENDIAN_TAG = 0x01020304;
+
+// fixed-size fields go through uint64 / uint8 so the file does not depend
+// on sizeof(long), sizeof(size_t) or sizeof(bool)
+class CheckpointOut{
+    private:
+        FILE* file;
+    public:
+        bool ok = true;
+        explicit CheckpointOut(FILE* f): file(f){}
+        void raw(const void* data, size_t bytes){
+            if (ok && bytes > 0 && fwrite(data, 1, bytes, file) != bytes){
+                ok = false;
+            }
+        }
+        template <typename T>
+        void value(T& v){
+            static_assert(is_floating_point<T>::value || is_same<T, uint32_t>::value
+                          || is_same<T, int32_t>::value, "unsized field");
+            raw(&v, sizeof(T));
+        }
+        template <typename T>
+        void u64(T& v){
+            uint64_t w = (uint64_t)v;
+            raw(&w, sizeof(w));
+        }
+        void flag(bool& v){
+            uint8_t w = v ? 1 : 0;
+            raw(&w, 1);
+        }
+        template <typename T>
+        void array(vector<T>& v){
+            uint64_t count = v.size();
+            raw(&count, sizeof(count));
+            raw(v.data(), count * sizeof(T));
+        }
+};
+
+class CheckpointIn{
+    private:
+        const char* cur;
+        const char* end;
+    public:
+        bool ok = true;
+        CheckpointIn(const char* begin, const char* e): cur(begin), end(e){}
+        void raw(void* data, size_t bytes){
+            if (!ok || (size_t)(end - cur) < bytes){
+                ok = false;
+                return;
+            }
+            memcpy(data, cur, bytes);
+            cur += bytes;
+        }
+        template <typename T>
+        void value(T& v){
+            raw(&v, sizeof(T));
+        }
+        template <typename T>
+        void u64(T& v){
+            uint64_t w = 0;
+            raw(&w, sizeof(w));
+            v = (T)w;
+        }
+        void flag(bool& v){
+            uint8_t w = 0;
+            raw(&w, 1);
+            v = w != 0;
+        }
+        template <typename T>
+        void array(vector<T>& v){
+            uint64_t count = 0;
+            raw(&count, sizeof(count));
+            if (!ok || count > (uint64_t)(end - cur) / sizeof(T)){
+                ok = false;
+                return;
+            }
+            v.resize(count);
+            raw(v.data(), count * sizeof(T));
+        }
+        const char* position(){
+            return cur;
+        }
+};
+
+template <typename Archive>
+static void visitLobes(Archive& a, vector<MarginLobe>& lobes){
+    uint64_t count = lobes.size();
+    a.u64(count);
+    if (!a.ok || count > MARGIN_INDEX_MAX_RINGS){
+        a.ok = false;
+        return;
+    }
+    lobes.resize(count);
+    for (MarginLobe& lobe : lobes){
+        Superformula& s = lobe.shape;
+        float shape[7] = {s.getM(), s.getN1(), s.getN2(), s.getN3(), s.getA(), s.getB(), s.getScale()};
+        for (float& f : shape){
+            a.value(f);
+        }
+        if (!s.set(shape[0], shape[1], shape[2], shape[3], shape[4], shape[5], shape[6])){
+            a.ok = false;
+        }
+        a.value(lobe.x);
+        a.value(lobe.y);
+        a.value(lobe.rotation);
+        a.value(lobe.rate);
+    }
+}
+
+// the one list of fields, shared by reading and writing
+template <typename Archive>
+static void visitCheckpoint(Archive& a, CheckpointData& d){
+    SimulationParams& p = d.params;
+    a.u64(p.seed);
+    a.value(p.initGrowth);
+    a.value(p.smallChange);
+    a.value(p.srcSrcDist);
+    a.value(p.srcNodeDist);
+    a.value(p.nodeNodeDist);
+    a.value(p.killDist);
+    a.value(p.initUnitDist);
+    a.value(p.midribSpacing);
+    a.value(p.marginSpacing);
+    a.u64(p.candidateBudget);
+    a.value(p.candidateMillis);
+    a.u64(p.candidateMaxAge);
+    a.value(p.scheduleAreaFraction);
+    a.u64(p.scheduleMinLiveSources);
+    a.u64(p.threads);
+    a.u64(p.macroMaxSteps);
+    a.value(p.macroAreaExcess);
+    a.u64(p.macroActivityThreshold);
+    a.flag(p.idleJump);
+    a.u64(p.maxIdleJump);
+    float shape[7] = {p.shape.getM(), p.shape.getN1(), p.shape.getN2(), p.shape.getN3(),
+                      p.shape.getA(), p.shape.getB(), p.shape.getScale()};
+    for (float& f : shape){
+        a.value(f);
+    }
+    if (!p.shape.set(shape[0], shape[1], shape[2], shape[3], shape[4], shape[5], shape[6])){
+        a.ok = false;
+    }
+    a.u64(p.marginResolution);
+    a.value(p.marginMaxEdge);
+    a.value(p.marginMinEdge);
+    a.value(p.marginMaxTurn);
+    uint64_t fieldCols = p.growthField.getCols(), fieldRows = p.growthField.getRows();
+    a.u64(fieldCols);
+    a.u64(fieldRows);
+    vector<float> tensors;
+    for (int j = 0; j < p.growthField.getRows(); j++){
+        for (int i = 0; i < p.growthField.getCols(); i++){
+            GrowthTensor t = p.growthField.get(i, j);
+            tensors.insert(tensors.end(), {t.xx, t.xy, t.yx, t.yy});
+        }
+    }
+    a.array(tensors);
+    if (a.ok && (fieldCols < 2 || fieldRows < 2 || fieldCols > 4096 || fieldRows > 4096
+                 || tensors.size() != 4 * fieldCols * fieldRows)){
+        a.ok = false;
+    }
+    if (a.ok){
+        GrowthField field((int)fieldCols, (int)fieldRows);
+        for (size_t k = 0; k < fieldCols * fieldRows; k++){
+            GrowthTensor t;
+            t.xx = tensors[4*k];
+            t.xy = tensors[4*k+1];
+            t.yx = tensors[4*k+2];
+            t.yy = tensors[4*k+3];
+            field.set((int)(k % fieldCols), (int)(k / fieldCols), t);
+        }
+        p.growthField = field;
+    }
+    a.flag(p.growthFieldSources);
+    a.flag(p.growthFieldNodes);
+    a.flag(p.expandTissue);
+    a.value(p.surfaceCup);
+    a.value(p.surfaceArch);
+    visitLobes(a, p.lobes);
+    a.array(p.outlineX);
+    a.array(p.outlineY);
+    a.u64(p.outlinePetiole);
+    a.u64(p.marginControls);
+    a.u64(p.marginDrawSamples);
+
+    a.u64(d.stepCount);
+    a.u64(d.nodes);
+    a.value(d.uniformGrowth);
+    a.value(d.marginGrowth);
+    a.value(d.unitDist);
+    a.value(d.petiole_x);
+    a.value(d.petiole_y);
+    a.value(d.org_x);
+    a.value(d.org_y);
+    a.value(d.scheduleLastArea);
+    a.flag(d.scheduleHasRun);
+    a.u64(d.scheduleRuns);
+    a.u64(d.scheduleSkipped);
+    a.u64(d.scheduleAdmitted);
+
+    a.array(d.marginX);
+    a.array(d.marginY);
+    a.array(d.marginAngles);
+    a.array(d.marginRates);
+    a.array(d.marginScales);
+    a.u64(d.marginPetiole);
+    a.flag(d.marginOnCurve);
+    a.u64(d.marginSplineSamples);
+    visitLobes(a, d.marginLobes);
+    a.array(d.marginRings);
+    a.array(d.nodeX);
+    a.array(d.nodeY);
+    a.array(d.nodeParent);
+    a.array(d.sourcePos);
+    a.array(d.sourceBirth);
+    a.array(d.sourceNearest);
+    a.array(d.sourceDist);
+
+    uint64_t candidateCount = d.candidates.size();
+    a.u64(candidateCount);
+    d.candidates.resize(a.ok ? candidateCount : 0);
+    for (SourceCandidate& c : d.candidates){
+        if (!a.ok) break;
+        a.value(c.x);
+        a.value(c.y);
+        a.u64(c.step);
+        a.value(c.order);
+    }
+    a.u64(d.candidatesDropped);
+
+    a.u64(d.macroSteps);
+    a.u64(d.mergedSteps);
+    a.value(d.macroMaxExcess);
+
+    StageCounters& c = d.counters;
+    a.u64(c.sampleRuns);
+    a.u64(c.sampleSkips);
+    a.u64(c.nearestRuns);
+    a.u64(c.nearestSkips);
+    a.u64(c.placeRuns);
+    a.u64(c.placeSkips);
+    a.u64(c.idleJumps);
+    a.u64(c.jumpedSteps);
+}
+
+bool writeCheckpoint(FILE* file, const CheckpointData& data){
+    CheckpointOut out(file);
+    uint32_t version = CHECKPOINT_VERSION;
+    uint32_t endian = ENDIAN_TAG;
+    out.raw(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    out.value(version);
+    out.value(endian);
+    visitCheckpoint(out, const_cast<CheckpointData&>(data));
+    return out.ok;
+}
+
+bool writeCheckpoint(const char* path, const CheckpointData& data){
+    string tmpPath = string(path) + ".tmp";
+    FILE* file = fopen(tmpPath.c_str(), "wb");
+    if (file == NULL){
+        fprintf(stderr, "Error opening %s: ", tmpPath.c_str()); perror("");
+        return false;
+    }
+    bool ok = writeCheckpoint(file, data);
+    if (fclose(file) != 0){
+        ok = false;
+    }
+    if (!ok){
+        fprintf(stderr, "Error writing checkpoint %s\n", tmpPath.c_str());
+        remove(tmpPath.c_str());
+        return false;
+    }
+    if (rename(tmpPath.c_str(), path) != 0){
+        fprintf(stderr, "Error renaming %s: ", tmpPath.c_str()); perror("");
+        return false;
+    }
+    return true;
+}
+
+bool parseCheckpoint(const char* begin, size_t length, size_t& used, CheckpointData& data, const char* source){
+    CheckpointIn in(begin, begin + length);
+    char magic[8];
+    uint32_t version = 0, endian = 0;
+    in.raw(magic, sizeof(magic));
+    in.value(version);
+    in.value(endian);
+    if (!in.ok || memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0){
+        fprintf(stderr, "Error: %s is not a checkpoint\n", source);
+        return false;
+    }
+    if (version != CHECKPOINT_VERSION){
+        fprintf(stderr, "Error: %s has checkpoint version %u, expected %u\n", source, version, CHECKPOINT_VERSION);
+        return false;
+    }
+    if (endian != ENDIAN_TAG){
+        fprintf(stderr, "Error: %s was written on a machine of different endianness\n", source);
+        return false;
+    }
+    visitCheckpoint(in, data);
+    if (!in.ok){
+        fprintf(stderr, "Error: %s is truncated or corrupt\n", source);
+        return false;
+    }
+    used = in.position() - begin;
+    return true;
+}
+
+bool loadCheckpoint(const char* path, CheckpointData& data){
+    int fd = open(path, O_RDONLY);
+    if (fd < 0){
+        fprintf(stderr, "Error opening %s: ", path); perror("");
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0){
+        fprintf(stderr, "Error reading %s: empty or unreadable\n", path);
+        close(fd);
+        return false;
+    }
+    size_t length = (size_t)info.st_size;
+    void* mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED){
+        fprintf(stderr, "Error mapping %s: ", path); perror("");
+        return false;
+    }
+    size_t used = 0;
+    bool ok = parseCheckpoint(static_cast<const char*>(mapped), length, used, data, path);
+    if (ok && used != length){
+        fprintf(stderr, "Error: %s has trailing data\n", path);
+        ok = false;
+    }
+    munmap(mapped, length);
+    return ok;
+}
+
+void CheckpointWriter::write(CheckpointData&& data, const string& path){
+    wait();
+    busy = true;
+    worker = thread([this, path](CheckpointData d){
+        lastOk = writeCheckpoint(path.c_str(), d);
+        busy = false;
+    }, move(data));
+}
+
+bool CheckpointWriter::wait(){
+    if (worker.joinable()){
+        worker.join();
+    }
+    return lastOk;
+}
\ No newline at end of file
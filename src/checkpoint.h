@@ -0,0 +1,77 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "leafsimulation.h"
+
+#define CHECKPOINT_VERSION 11
+
+// Everything needed to continue a run bit-identically. The vein tree is
+// flattened in preorder with parent indices (-1 for the petiole), which
+// keeps child order and so the order nodes are visited and grown. The RNG
+// is counter based, so seed and step are all of its state.
+struct CheckpointData{
+    SimulationParams params;
+    uint64_t stepCount = 0;
+    uint64_t nodes = 0;
+    float uniformGrowth = 0.0f, marginGrowth = 0.0f, unitDist = 0.0f;
+    float petiole_x = 0.0f, petiole_y = 0.0f;
+    float org_x = 0.0f, org_y = 0.0f;
+    float scheduleLastArea = 0.0f;
+    bool scheduleHasRun = false;
+    unsigned long scheduleRuns = 0, scheduleSkipped = 0, scheduleAdmitted = 0;
+    std::vector<float> marginX, marginY, marginAngles, marginRates, marginScales;
+    uint64_t marginPetiole = 0;
+    bool marginOnCurve = true;
+    uint64_t marginSplineSamples = 0; // table points per span, 0 = polyline margin
+    std::vector<MarginLobe> marginLobes;
+    std::vector<uint64_t> marginRings;
+    std::vector<float> nodeX, nodeY;
+    std::vector<int32_t> nodeParent;
+    std::vector<float> sourcePos; // x, y per source, dense order
+    std::vector<uint64_t> sourceBirth;
+    std::vector<int32_t> sourceNearest; // preorder node index
+    std::vector<float> sourceDist;
+    std::vector<SourceCandidate> candidates; // in processing order
+    unsigned long candidatesDropped = 0;
+    unsigned long macroSteps = 0, mergedSteps = 0;
+    float macroMaxExcess = 0.0f;
+    StageCounters counters;
+};
+
+// writes to `path`.tmp and renames, so a crash never leaves a torn file
+bool writeCheckpoint(const char* path, const CheckpointData& data);
+// maps the file and validates magic, version and every section length
+bool loadCheckpoint(const char* path, CheckpointData& data);
+// the same format embedded in another file (see StepJournal); parsing sets
+// `used` to the number of bytes the checkpoint takes, errors name `source`
+bool writeCheckpoint(FILE* file, const CheckpointData& data);
+bool parseCheckpoint(const char* begin, size_t length, size_t& used, CheckpointData& data, const char* source);
+
+// Writes captured checkpoints on a background thread so the simulation
+// only pays for the copy. A new write waits for the previous one.
+class CheckpointWriter{
+    private:
+        std::thread worker;
+        std::atomic<bool> busy{false};
+        std::atomic<bool> lastOk{true};
+    public:
+        ~CheckpointWriter(){
+            wait();
+        }
+        void write(CheckpointData&& data, const std::string& path);
+        // returns whether the last write succeeded
+        bool wait();
+        bool isBusy(){
+            return busy;
+        }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "growthfield.h"
+
+#include <algorithm>
+
+#include "simdkernels.h"
+
+using namespace std;
+
+GrowthField::GrowthField(int cols, int rows):
+    nx(max(cols, 2)), ny(max(rows, 2)), tensors(4 * nx * ny, 0.0f){
+    for (int k = 0; k < nx * ny; k++){
+        tensors[4 * k] = 1.0f;
+        tensors[4 * k + 3] = 1.0f;
+    }
+}
+
+void GrowthField::set(int i, int j, const GrowthTensor& t){
+    float* c = &tensors[4 * (j * nx + i)];
+    c[0] = t.xx;
+    c[1] = t.xy;
+    c[2] = t.yx;
+    c[3] = t.yy;
+    if (t.xx != 1.0f || t.xy != 0.0f || t.yx != 0.0f || t.yy != 1.0f){
+        identity = false;
+    }
+}
+
+void GrowthField::setFunction(const GrowthFunction& f){
+    for (int j = 0; j < ny; j++){
+        for (int i = 0; i < nx; i++){
+            set(i, j, f((float)i / (nx - 1), (float)j / (ny - 1)));
+        }
+    }
+}
+
+GrowthTensor GrowthField::get(int i, int j) const {
+    const float* c = &tensors[4 * (j * nx + i)];
+    GrowthTensor t;
+    t.xx = c[0];
+    t.xy = c[1];
+    t.yx = c[2];
+    t.yy = c[3];
+    return t;
+}
+
+GrowthTensor GrowthField::sample(float u, float v) const {
+    float fx = min(max(u, 0.0f), 1.0f) * (nx - 1);
+    float fy = min(max(v, 0.0f), 1.0f) * (ny - 1);
+    int i = min((int)fx, nx - 2);
+    int j = min((int)fy, ny - 2);
+    float tx = fx - i, ty = fy - j;
+    float w00 = (1 - tx) * (1 - ty), w10 = tx * (1 - ty);
+    float w01 = (1 - tx) * ty, w11 = tx * ty;
+    const float* c00 = &tensors[4 * (j * nx + i)];
+    const float *c10 = c00 + 4, *c01 = c00 + 4 * nx, *c11 = c01 + 4;
+    float b[4];
+    for (int m = 0; m < 4; m++){
+        b[m] = w00 * c00[m] + w10 * c10[m] + w01 * c01[m] + w11 * c11[m];
+    }
+    GrowthTensor t;
+    t.xx = b[0];
+    t.xy = b[1];
+    t.yx = b[2];
+    t.yy = b[3];
+    return t;
+}
+
+void GrowthField::apply(float* xs, float* ys, size_t stride, size_t n, float cx, float cy, float growth,
+                        const array<float, 4>& box) const {
+    float sx = (nx - 1) / max(box[2] - box[0], 1e-12f);
+    float sy = (ny - 1) / max(box[3] - box[1], 1e-12f);
+    growthFieldPass(xs, ys, stride, n, tensors.data(), nx, ny, box[0], box[1], sx, sy, cx, cy, growth);
+}
+
+GrowthFunction baseToTipGrowth(float base, float tip, float width){
+    return [base, tip, width](float u, float){
+        GrowthTensor t;
+        t.xx = base + (tip - base) * u;
+        t.yy = width * t.xx;
+        return t;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef GROWTH_FIELD_H
+#define GROWTH_FIELD_H
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Local growth relative to the leaf's own rate: a point at offset d from
+// the petiole moves by growth * T d. The identity is the isotropic growth
+// the leaf has without a field.
+struct GrowthTensor{
+    float xx = 1.0f, xy = 0.0f;
+    float yx = 0.0f, yy = 1.0f;
+};
+
+// Growth tensor at normalised leaf coordinates: u runs from the petiole
+// end of the bounding box (0) to the tip (1), v from bottom to top.
+typedef std::function<GrowthTensor(float, float)> GrowthFunction;
+
+// Growth tensors on a coarse grid over the leaf's bounding box, sampled
+// with bilinear interpolation. Each node keeps its four components side
+// by side, so a pass loads a corner's whole tensor at once.
+class GrowthField{
+    private:
+        int nx, ny;
+        std::vector<float> tensors; // xx, xy, yx, yy per node, row by row
+        bool identity = true;
+    public:
+        GrowthField(int cols = 2, int rows = 2);
+        void set(int i, int j, const GrowthTensor& t);
+        // evaluates `f` at every grid node
+        void setFunction(const GrowthFunction& f);
+        GrowthTensor sample(float u, float v) const;
+        // One pass over n points stored at xs[k * stride], ys[k * stride]:
+        // each moves by growth * T (p - c), with T sampled where the point
+        // lies in `box` (x min, y min, x max, y max).
+        void apply(float* xs, float* ys, size_t stride, size_t n, float cx, float cy, float growth,
+                   const std::array<float, 4>& box) const;
+        // true until a non-identity tensor is set
+        bool isIdentity() const {
+            return identity;
+        }
+        int getCols() const {
+            return nx;
+        }
+        int getRows() const {
+            return ny;
+        }
+        GrowthTensor get(int i, int j) const;
+};
+
+// rate going linearly from `base` at the petiole end to `tip`, with growth
+// across the blade `width` times growth along it
+GrowthFunction baseToTipGrowth(float base, float tip, float width = 1.0f);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include "journal.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char JOURNAL_MAGIC[8] = {'L', 'E', 'A', 'F', 'J', 'R', 'N', 'L'};
+
+// fixed part of a record, followed by the three event arrays
+struct RecordHeader{
+    uint64_t step;
+    uint64_t hash;
+    uint32_t increments;
+    uint32_t created;
+    uint32_t killed;
+    uint32_t added;
+};
+
+bool StepJournal::open(const char* path, const CheckpointData& base){
+    close();
+    file = fopen(path, "wb");
+    if (file == NULL){
+        fprintf(stderr, "Error opening %s: ", path); perror("");
+        return false;
+    }
+    uint32_t version = JOURNAL_VERSION;
+    ok = fwrite(JOURNAL_MAGIC, 1, sizeof(JOURNAL_MAGIC), file) == sizeof(JOURNAL_MAGIC)
+        && fwrite(&version, sizeof(version), 1, file) == 1
+        && writeCheckpoint(file, base);
+    records = 0;
+    if (!ok){
+        fprintf(stderr, "Error writing journal %s\n", path);
+        close();
+    }
+    return ok;
+}
+
+void StepJournal::record(const JournalStep& s){
+    if (!file || !ok) return;
+    RecordHeader h = {s.step, s.hash, s.increments, (uint32_t)(s.created.size() / 2),
+                      (uint32_t)s.killed.size(), (uint32_t)s.added.size()};
+    ok = fwrite(&h, sizeof(h), 1, file) == 1;
+    if (ok && h.created > 0){
+        ok = fwrite(s.created.data(), sizeof(float), s.created.size(), file) == s.created.size();
+    }
+    if (ok && h.killed > 0){
+        ok = fwrite(s.killed.data(), sizeof(uint32_t), h.killed, file) == h.killed;
+    }
+    if (ok && h.added > 0){
+        ok = fwrite(s.added.data(), sizeof(JournalNode), h.added, file) == h.added;
+    }
+    if (!ok){
+        fprintf(stderr, "Error writing journal record for step %llu\n", (unsigned long long)s.step);
+    }
+    records++;
+}
+
+bool StepJournal::close(){
+    if (!file) return ok;
+    if (fclose(file) != 0){
+        ok = false;
+    }
+    file = nullptr;
+    return ok;
+}
+
+JournalReader::~JournalReader(){
+    if (mapped){
+        munmap((void*)mapped, length);
+    }
+}
+
+bool JournalReader::open(const char* journalPath){
+    path = journalPath;
+    int fd = ::open(journalPath, O_RDONLY);
+    if (fd < 0){
+        fprintf(stderr, "Error opening %s: ", journalPath); perror("");
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0){
+        fprintf(stderr, "Error reading %s: empty or unreadable\n", journalPath);
+        ::close(fd);
+        return false;
+    }
+    length = (size_t)info.st_size;
+    void* m = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED){
+        fprintf(stderr, "Error mapping %s: ", journalPath); perror("");
+        length = 0;
+        return false;
+    }
+    mapped = static_cast<const char*>(m);
+    uint32_t version = 0;
+    if (length < sizeof(JOURNAL_MAGIC) + sizeof(version) || memcmp(mapped, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0){
+        fprintf(stderr, "Error: %s is not a step journal\n", journalPath);
+        return false;
+    }
+    memcpy(&version, mapped + sizeof(JOURNAL_MAGIC), sizeof(version));
+    if (version != JOURNAL_VERSION){
+        fprintf(stderr, "Error: %s has journal version %u, expected %u\n", journalPath, version, JOURNAL_VERSION);
+        return false;
+    }
+    offset = sizeof(JOURNAL_MAGIC) + sizeof(version);
+    size_t used = 0;
+    if (!parseCheckpoint(mapped + offset, length - offset, used, base, journalPath)){
+        return false;
+    }
+    offset += used;
+    return true;
+}
+
+bool JournalReader::next(JournalStep& s){
+    if (!mapped || corrupt || offset == length) return false;
+    RecordHeader h;
+    size_t left = length - offset;
+    if (left < sizeof(h)){
+        corrupt = true;
+    }
+    else {
+        memcpy(&h, mapped + offset, sizeof(h));
+        size_t body = 2 * sizeof(float) * (size_t)h.created + sizeof(uint32_t) * (size_t)h.killed
+            + sizeof(JournalNode) * (size_t)h.added;
+        corrupt = left - sizeof(h) < body;
+    }
+    if (corrupt){
+        fprintf(stderr, "Error: %s ends in a truncated record\n", path.c_str());
+        return false;
+    }
+    const char* p = mapped + offset + sizeof(h);
+    s.step = h.step;
+    s.hash = h.hash;
+    s.increments = h.increments;
+    s.created.resize(2 * (size_t)h.created);
+    memcpy(s.created.data(), p, s.created.size() * sizeof(float));
+    p += s.created.size() * sizeof(float);
+    s.killed.resize(h.killed);
+    memcpy(s.killed.data(), p, s.killed.size() * sizeof(uint32_t));
+    p += s.killed.size() * sizeof(uint32_t);
+    s.added.resize(h.added);
+    memcpy(s.added.data(), p, s.added.size() * sizeof(JournalNode));
+    p += s.added.size() * sizeof(JournalNode);
+    offset = p - mapped;
+    return true;
+}
+
+template <typename T>
+static bool sameBytes(const vector<T>& a, const vector<T>& b){
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+}
+
+// names the first field two records disagree on, or returns false
+static bool recordsDiffer(const JournalStep& a, const JournalStep& b, string& reason){
+    if (a.step != b.step){
+        reason = "step count " + to_string(a.step) + " vs " + to_string(b.step);
+    }
+    else if (a.increments != b.increments){
+        reason = "growth increments " + to_string(a.increments) + " vs " + to_string(b.increments);
+    }
+    else if (!sameBytes(a.created, b.created)){
+        reason = "sources created (" + to_string(a.created.size() / 2) + " vs " + to_string(b.created.size() / 2) + ")";
+    }
+    else if (!sameBytes(a.killed, b.killed)){
+        reason = "sources killed (" + to_string(a.killed.size()) + " vs " + to_string(b.killed.size()) + ")";
+    }
+    else if (!sameBytes(a.added, b.added)){
+        reason = "nodes added (" + to_string(a.added.size()) + " vs " + to_string(b.added.size()) + ")";
+    }
+    else if (a.hash != b.hash){
+        reason = "state hash";
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+bool compareJournals(const char* pathA, const char* pathB, JournalDiff& diff){
+    JournalReader a, b;
+    if (!a.open(pathA) || !b.open(pathB)){
+        return false;
+    }
+    diff = JournalDiff();
+    diff.step = a.getBase().stepCount;
+    if (a.getBase().stepCount != b.getBase().stepCount){
+        diff.diverged = true;
+        diff.reason = "journals start at different steps";
+        return true;
+    }
+    JournalStep ra, rb;
+    while (true){
+        bool hasA = a.next(ra);
+        bool hasB = b.next(rb);
+        if (a.isCorrupt() || b.isCorrupt()){
+            return false;
+        }
+        if (!hasA && !hasB){
+            return true;
+        }
+        if (hasA != hasB){
+            diff.diverged = true;
+            diff.step = hasA ? ra.step : rb.step;
+            diff.reason = string(hasA ? pathB : pathA) + " ends first";
+            return true;
+        }
+        if (recordsDiffer(ra, rb, diff.reason)){
+            diff.diverged = true;
+            diff.step = ra.step;
+            return true;
+        }
+        diff.matched++;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "checkpoint.h"
+
+#define JOURNAL_VERSION 1
+
+struct JournalNode{
+    uint32_t parent; // id of the node it grew from
+    float x;
+    float y;
+};
+
+// What one call of LeafSimulation::step() changed, in the order it
+// happened: sources admitted, then sources killed, then nodes placed, then
+// `increments` growth increments.
+struct JournalStep{
+    uint64_t step = 0;              // step count after the step
+    uint32_t increments = 0;
+    std::vector<float> created;     // x, y per admitted source
+    std::vector<uint32_t> killed;   // dense source indices, in removal order
+    std::vector<JournalNode> added; // in placement order
+    uint64_t hash = 0;              // LeafSimulation::stateHash() after the step
+    void clear(){
+        created.clear();
+        killed.clear();
+        added.clear();
+    }
+};
+
+// Appends one record per step to a file that starts with a checkpoint of
+// the state the journal was opened on. Records go through stdio buffering,
+// so recording costs little more than the state hash.
+class StepJournal{
+    private:
+        FILE* file = nullptr;
+        bool ok = true;
+        unsigned long records = 0;
+    public:
+        ~StepJournal(){
+            close();
+        }
+        bool open(const char* path, const CheckpointData& base);
+        void record(const JournalStep& s);
+        bool close();
+        bool isOpen(){
+            return file != nullptr;
+        }
+        unsigned long getRecords(){
+            return records;
+        }
+};
+
+// Maps a journal and walks its records.
+class JournalReader{
+    private:
+        std::string path;
+        const char* mapped = nullptr;
+        size_t length = 0;
+        size_t offset = 0;
+        bool corrupt = false;
+        CheckpointData base;
+    public:
+        ~JournalReader();
+        bool open(const char* journalPath);
+        const CheckpointData& getBase(){
+            return base;
+        }
+        // false at the end of the journal or on a damaged record
+        bool next(JournalStep& s);
+        bool isCorrupt(){
+            return corrupt;
+        }
+};
+
+struct JournalDiff{
+    bool diverged = false;
+    uint64_t step = 0;  // first step that differs
+    std::string reason;
+    unsigned long matched = 0; // records equal before it
+};
+
+// compares two journals record by record; false if either can't be read
+bool compareJournals(const char* pathA, const char* pathB, JournalDiff& diff);
+
+#endif
\ No newline at end of file
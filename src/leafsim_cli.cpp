@@ -0,0 +1,581 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "checkpoint.h"
+#include "journal.h"
+#include "leafsimulation.h"
+#include "macrocheck.h"
+#include "outline.h"
+#include "stepgenerator.h"
+
+using namespace std;
+
+static void usage(const char* prog){
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --steps N            steps to simulate (default 1000 without other targets)\n"
+        "  --until-nodes N      stop once the tree has N nodes\n"
+        "  --until-area A       stop once the leaf area reaches A\n"
+        "  --seed S             random seed (default 1)\n"
+        "  --out FILE           write margin, veins and sources as OBJ (default leaf.obj)\n"
+        "  --budget N           auxin candidates admitted per step, 0 = all\n"
+        "  --budget-ms T        ... or for at most T ms per step, 0 = unlimited (not reproducible)\n"
+        "  --threads N          worker threads, 0 = all cores (default)\n"
+        "  --area-fraction F    resample once the leaf area grew by F (default 0.01)\n"
+        "  --min-live N         ... or once fewer than N sources are live (default 8)\n"
+        "  --no-idle-jump       step through idle stretches one step at a time\n"
+        "  --macro K            merge up to K growth increments while venation is quiet\n"
+        "  --macro-excess T     bound on a macro-step's predicted extra leaf area (default 0.01)\n"
+        "  --macro-quiet N      ... counting up to N live sources and pending candidates as quiet\n"
+        "  --check-macro        replay every macro-step one increment at a time and fail if\n"
+        "                       it moved the margin, sources or tree by more than T (slow)\n"
+        "  --midrib-spacing F   source spacing multiplier along the midrib\n"
+        "  --margin-spacing F   source spacing multiplier at the margin\n"
+        "  --shape M,N1,N2,N3,A,B[,S]  superformula outline (default 2,1,1,1,2,1,20)\n"
+        "  --lobe M,N1,N2,N3,A,B,S,X,Y[,ROT,RATE]  add a superformula lobe centred on (X, Y),\n"
+        "                       turned by ROT radians and growing at RATE (repeatable)\n"
+        "  --outline FILE       digitised leaf outline (.svg path, .bin float pairs or x,y text)\n"
+        "                       in place of the superformula lobes\n"
+        "  --petiole X,Y        outline point nearest the petiole, SVG y negated (default: least x)\n"
+        "  --outline-length L   outline length from petiole to tip (default 60)\n"
+        "  --margin-res N       initial margin vertices per half turn (default 100)\n"
+        "  --spline N[,D]       B-spline margin with N control points per lobe, drawn and\n"
+        "                       exported at D points per span (default 8)\n"
+        "  --margin-max-edge F  subdivide margin edges longer than F source spacings, 0 = never\n"
+        "  --margin-max-turn A  ... and edges next to vertices turning more than A radians\n"
+        "  --growth B,T[,W]     growth field: rate B at the petiole end to T at the tip,\n"
+        "                       W times that across the blade (default uniform)\n"
+        "  --growth-carry WHAT  the field also moves sources (default), nodes, all or none\n"
+        "  --surface CUP,ARCH   curve the blade across and along the midrib (default flat)\n"
+        "  --compare-flat       then grow the same leaf flat to as many nodes and compare times\n"
+        "  --expand             grow by moving everything apart, keeping distances fixed\n"
+        "  --resume FILE        continue from a checkpoint (its parameters replace the above)\n"
+        "  --checkpoint FILE    write a checkpoint at the end of the run\n"
+        "  --checkpoint-every N ... and every N steps along the way\n"
+        "  --journal FILE       record a per-step journal of the run\n"
+        "  --replay FILE        rebuild the leaf from a journal instead of simulating\n"
+        "  --replay-step N      ... stopping at step N (default: the last record)\n"
+        "  --diff A B           report the first step where two journals differ\n"
+        "  --trace              print one line per step (segments added, sources killed, time)\n",
+        prog);
+}
+
+// margin as closed polylines, one per lobe, veins as segments, sources as
+// points, and on a curved leaf the blade as triangles
+static bool writeObj(const char* path, LeafSimulation& sim){
+    FILE* out = fopen(path, "w");
+    if (out == NULL){
+        fprintf(stderr, "Error opening %s: ", path); perror("");
+        return false;
+    }
+    fprintf(out, "# leaf venation, step %llu, seed %llu\n",
+            (unsigned long long)sim.getStep(), (unsigned long long)sim.getParams().seed);
+    LeafMargin& margin = sim.getLeafMargin();
+    const LeafSurface& surface = sim.getSurface();
+    vector<float> coords;
+    vector<int> rings;
+    margin.fillCoords(coords, rings, sim.getParams().marginDrawSamples);
+    size_t marginCount = coords.size() / 3;
+    for (size_t i = 0; i < marginCount; i++){
+        float x = coords[3*i], y = coords[3*i+1];
+        fprintf(out, "v %f %f %f\n", x, y, surface.height(x, y));
+    }
+    fprintf(out, "o margin\n");
+    for (size_t k = 0; k + 1 < rings.size(); k++){
+        fprintf(out, "l");
+        for (int i = rings[k]; i < rings[k + 1]; i++){
+            fprintf(out, " %d", i + 1);
+        }
+        fprintf(out, " %d\n", rings[k] + 1);
+    }
+
+    vector<float> veins;
+    sim.flattenNodes(veins);
+    size_t base = marginCount;
+    for (size_t i = 0; i < veins.size(); i += 3){
+        fprintf(out, "v %f %f %f\n", veins[i], veins[i+1], veins[i+2]);
+    }
+    fprintf(out, "o veins\n");
+    for (size_t i = 0; i < veins.size() / 3; i += 2){
+        fprintf(out, "l %zu %zu\n", base + i + 1, base + i + 2);
+    }
+
+    AuxinStore& sources = sim.getSources();
+    base += veins.size() / 3;
+    for (size_t i = 0; i < sources.size(); i++){
+        float x = sources.getX(i), y = sources.getY(i);
+        if (surface.isFlat()){
+            fprintf(out, "v %f %f 0.0\n", x, y);
+        }
+        else {
+            fprintf(out, "v %f %f %f\n", x, y, surface.height(x, y));
+        }
+    }
+    fprintf(out, "o sources\n");
+    for (size_t i = 0; i < sources.size(); i++){
+        fprintf(out, "p %zu\n", base + i + 1);
+    }
+
+    if (!surface.isFlat()){
+        vector<float> mesh;
+        vector<uint32_t> triangles;
+        surface.triangulate(margin, 64, mesh, triangles);
+        base += sources.size();
+        for (size_t i = 0; i < mesh.size(); i += 3){
+            fprintf(out, "v %f %f %f\n", mesh[i], mesh[i+1], mesh[i+2]);
+        }
+        fprintf(out, "o surface\n");
+        for (size_t i = 0; i < triangles.size(); i += 3){
+            fprintf(out, "f %zu %zu %zu\n", base + triangles[i] + 1, base + triangles[i+1] + 1, base + triangles[i+2] + 1);
+        }
+    }
+    fclose(out);
+    return true;
+}
+
+// critical-path time of one stage, summed over the run
+static double stageMillis(LeafSimulation& sim, const char* name){
+    for (const StageTiming& t : sim.getCriticalTotals()){
+        if (t.name == name){
+            return t.millis;
+        }
+    }
+    return 0.0;
+}
+
+// Grows the leaf again from the start with the blade flat until it has as
+// many nodes as the curved one, then prints both runs' times: what the
+// surface distances cost at equal node count.
+static void compareFlat(LeafSimulation& curved, double curvedSeconds){
+    SimulationParams params = curved.getParams();
+    params.surfaceCup = 0.0f;
+    params.surfaceArch = 0.0f;
+    LeafSimulation flat(params);
+    RunTarget target;
+    target.nodeCount = curved.nodeCount();
+    auto start = chrono::steady_clock::now();
+    flat.runUntil(target);
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    double curvedNearest = stageMillis(curved, "nearest");
+    double flatNearest = stageMillis(flat, "nearest");
+    printf("curved: %zu nodes, %llu steps, %.3f s, nearest %.3f ms\n", curved.nodeCount(),
+           (unsigned long long)curved.getStep(), curvedSeconds, curvedNearest);
+    printf("flat:   %zu nodes, %llu steps, %.3f s, nearest %.3f ms\n", flat.nodeCount(),
+           (unsigned long long)flat.getStep(), elapsed.count(), flatNearest);
+    printf("curved / flat: %.2fx run, %.2fx nearest\n", curvedSeconds / max(elapsed.count(), 1e-9),
+           curvedNearest / max(flatNearest, 1e-9));
+}
+
+// rebuilds the state at `untilStep` from a journal, checking the state hash
+// after every record
+static int replayJournal(const char* path, uint64_t untilStep, const char* outPath){
+    JournalReader reader;
+    if (!reader.open(path)){
+        return 1;
+    }
+    LeafSimulation sim(reader.getBase().params);
+    if (!sim.restoreCheckpoint(reader.getBase())){
+        return 1;
+    }
+    auto start = chrono::steady_clock::now();
+    JournalStep s;
+    unsigned long records = 0;
+    while ((untilStep == 0 || sim.getStep() < untilStep) && reader.next(s)){
+        if (!sim.applyJournalStep(s)){
+            fprintf(stderr, "Error: the record for step %llu does not fit the replayed state\n",
+                    (unsigned long long)s.step);
+            return 1;
+        }
+        if (sim.stateHash() != s.hash){
+            printf("replayed state differs from the journal at step %llu\n", (unsigned long long)s.step);
+            return 1;
+        }
+        records++;
+    }
+    if (reader.isCorrupt()){
+        return 1;
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    printf("replayed %lu records to step %llu in %.3f s\n", records, (unsigned long long)sim.getStep(), elapsed.count());
+    printf("nodes: %zu\n", sim.nodeCount());
+    printf("auxin sources: %zu\n", sim.getSources().size());
+    return writeObj(outPath, sim) ? 0 : 1;
+}
+
+// Loads an outline into params, resampled to 2 * marginResolution vertices
+// with the petiole at vertex marginResolution, as the built-in leaf has it.
+static bool loadLeafOutline(const char* path, const float* petiole, float length, SimulationParams& params){
+    vector<float> xs, ys;
+    if (!loadOutline(path, xs, ys)){
+        return false;
+    }
+    size_t p = 0;
+    if (petiole){
+        p = nearestVertex(xs, ys, petiole[0], petiole[1]);
+    }
+    else {
+        p = min_element(xs.begin(), xs.end()) - xs.begin();
+    }
+    rotate(xs.begin(), xs.begin() + p, xs.end());
+    rotate(ys.begin(), ys.begin() + p, ys.end());
+    size_t half = max<size_t>(params.marginResolution, 2);
+    resampleOutline(xs, ys, 2 * half);
+    rotate(xs.begin(), xs.begin() + half, xs.end());
+    rotate(ys.begin(), ys.begin() + half, ys.end());
+    placeOutline(xs, ys, half, length);
+    params.outlineX.swap(xs);
+    params.outlineY.swap(ys);
+    params.outlinePetiole = half;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    SimulationParams params;
+    RunTarget target;
+    bool stepsGiven = false;
+    const char* outPath = "leaf.obj";
+    const char* resumePath = nullptr;
+    const char* checkpointPath = nullptr;
+    uint64_t checkpointEvery = 0;
+    const char* journalPath = nullptr;
+    const char* replayPath = nullptr;
+    uint64_t replayStep = 0;
+    const char* diffPaths[2] = {nullptr, nullptr};
+    bool trace = false;
+    bool checkMacro = false;
+    bool compare = false;
+    const char* outlinePath = nullptr;
+    float outlinePetiole[2];
+    bool petioleGiven = false;
+    float outlineLength = 60.0f;
+    for (int i = 1; i < argc; i++){
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--steps") && hasValue){
+            target.steps = strtoull(argv[++i], nullptr, 10);
+            stepsGiven = true;
+        }
+        else if (!strcmp(argv[i], "--until-nodes") && hasValue){
+            target.nodeCount = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--until-area") && hasValue){
+            target.leafArea = strtof(argv[++i], nullptr);
+        }
+        else if (!strcmp(argv[i], "--seed") && hasValue){
+            params.seed = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--out") && hasValue){
+            outPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--budget") && hasValue){
+            params.candidateBudget = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--budget-ms") && hasValue){
+            params.candidateMillis = strtod(argv[++i], nullptr);
+        }
+        else if (!strcmp(argv[i], "--threads") && hasValue){
+            params.threads = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--area-fraction") && hasValue){
+            params.scheduleAreaFraction = strtof(argv[++i], nullptr);
+        }
+        else if (!strcmp(argv[i], "--min-live") && hasValue){
+            params.scheduleMinLiveSources = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--no-idle-jump")){
+            params.idleJump = false;
+        }
+        else if (!strcmp(argv[i], "--macro") && hasValue){
+            params.macroMaxSteps = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--macro-excess") && hasValue){
+            params.macroAreaExcess = strtof(argv[++i], nullptr);
+        }
+        else if (!strcmp(argv[i], "--macro-quiet") && hasValue){
+            params.macroActivityThreshold = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--midrib-spacing") && hasValue){
+            params.midribSpacing = strtof(argv[++i], nullptr);
+        }
+        else if (!strcmp(argv[i], "--margin-spacing") && hasValue){
+            params.marginSpacing = strtof(argv[++i], nullptr);
+        }
+        else if (!strcmp(argv[i], "--shape") && hasValue){
+            float f[7] = {2.0f, 1.0f, 1.0f, 1.0f, 2.0f, 1.0f, 20.0f};
+            int count = sscanf(argv[++i], "%f,%f,%f,%f,%f,%f,%f", &f[0], &f[1], &f[2], &f[3], &f[4], &f[5], &f[6]);
+            if (count < 6){
+                usage(argv[0]);
+                return 1;
+            }
+            if (!params.shape.set(f[0], f[1], f[2], f[3], f[4], f[5], f[6])){
+                fprintf(stderr, "Error: --shape needs N1, A and B non-zero\n");
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "--lobe") && hasValue){
+            float f[11] = {2.0f, 1.0f, 1.0f, 1.0f, 2.0f, 1.0f, 20.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+            int count = sscanf(argv[++i], "%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f", &f[0], &f[1], &f[2], &f[3], &f[4],
+                               &f[5], &f[6], &f[7], &f[8], &f[9], &f[10]);
+            if (count < 9){
+                usage(argv[0]);
+                return 1;
+            }
+            if (params.lobes.size() + 1 >= MARGIN_INDEX_MAX_RINGS){
+                fprintf(stderr, "Error: at most %d --lobe options, the margin index holds %d rings\n",
+                        MARGIN_INDEX_MAX_RINGS - 1, MARGIN_INDEX_MAX_RINGS);
+                return 1;
+            }
+            MarginLobe lobe;
+            if (!lobe.shape.set(f[0], f[1], f[2], f[3], f[4], f[5], f[6])){
+                fprintf(stderr, "Error: --lobe needs N1, A and B non-zero\n");
+                return 1;
+            }
+            lobe.x = f[7];
+            lobe.y = f[8];
+            lobe.rotation = f[9];
+            lobe.rate = f[10];
+            params.lobes.push_back(lobe);
+        }
+        else if (!strcmp(argv[i], "--outline") && hasValue){
+            outlinePath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--petiole") && hasValue){
+            if (sscanf(argv[++i], "%f,%f", &outlinePetiole[0], &outlinePetiole[1]) < 2){
+                usage(argv[0]);
+                return 1;
+            }
+            petioleGiven = true;
+        }
+        else if (!strcmp(argv[i], "--outline-length") && hasValue){
+            outlineLength = strtof(argv[++i], nullptr);
+            if (!(outlineLength > 0.0f)){
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "--spline") && hasValue){
+            unsigned long controls = 0, draw = params.marginDrawSamples;
+            if (sscanf(argv[++i], "%lu,%lu", &controls, &draw) < 1 || controls < 4 || draw < 1){
+                usage(argv[0]);
+                return 1;
+            }
+            params.marginControls = controls;
+            params.marginDrawSamples = draw;
+        }
+        else if (!strcmp(argv[i], "--margin-res") && hasValue){
+            params.marginResolution = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--margin-max-edge") && hasValue){
+            params.marginMaxEdge = strtof(argv[++i], nullptr);
+        }
+        else if (!strcmp(argv[i], "--margin-max-turn") && hasValue){
+            params.marginMaxTurn = strtof(argv[++i], nullptr);
+        }
+        else if (!strcmp(argv[i], "--growth") && hasValue){
+            float f[3] = {1.0f, 1.0f, 1.0f};
+            if (sscanf(argv[++i], "%f,%f,%f", &f[0], &f[1], &f[2]) < 2){
+                usage(argv[0]);
+                return 1;
+            }
+            params.growthField = GrowthField(16, 16);
+            params.growthField.setFunction(baseToTipGrowth(f[0], f[1], f[2]));
+        }
+        else if (!strcmp(argv[i], "--growth-carry") && hasValue){
+            const char* what = argv[++i];
+            params.growthFieldSources = !strcmp(what, "sources") || !strcmp(what, "all");
+            params.growthFieldNodes = !strcmp(what, "nodes") || !strcmp(what, "all");
+            if (!params.growthFieldSources && !params.growthFieldNodes && strcmp(what, "none")){
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "--surface") && hasValue){
+            if (sscanf(argv[++i], "%f,%f", &params.surfaceCup, &params.surfaceArch) < 2){
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "--expand")){
+            params.expandTissue = true;
+        }
+        else if (!strcmp(argv[i], "--resume") && hasValue){
+            resumePath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--checkpoint") && hasValue){
+            checkpointPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--checkpoint-every") && hasValue){
+            checkpointEvery = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--journal") && hasValue){
+            journalPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--replay") && hasValue){
+            replayPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--replay-step") && hasValue){
+            replayStep = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--trace")){
+            trace = true;
+        }
+        else if (!strcmp(argv[i], "--check-macro")){
+            checkMacro = true;
+        }
+        else if (!strcmp(argv[i], "--compare-flat")){
+            compare = true;
+        }
+        else if (!strcmp(argv[i], "--diff") && i + 2 < argc){
+            diffPaths[0] = argv[++i];
+            diffPaths[1] = argv[++i];
+        }
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!stepsGiven && target.nodeCount == 0 && target.leafArea <= 0.0f){
+        target.steps = 1000;
+    }
+
+    if (diffPaths[0]){
+        JournalDiff diff;
+        if (!compareJournals(diffPaths[0], diffPaths[1], diff)){
+            return 2;
+        }
+        if (!diff.diverged){
+            printf("journals match (%lu records)\n", diff.matched);
+            return 0;
+        }
+        printf("journals diverge at step %llu after %lu matching records: %s\n",
+               (unsigned long long)diff.step, diff.matched, diff.reason.c_str());
+        return 1;
+    }
+    if (replayPath){
+        return replayJournal(replayPath, replayStep, outPath);
+    }
+
+    if (outlinePath && !loadLeafOutline(outlinePath, petioleGiven ? outlinePetiole : nullptr, outlineLength, params)){
+        return 1;
+    }
+
+    if (checkpointEvery > 0 && checkpointPath == nullptr){
+        fprintf(stderr, "--checkpoint-every needs --checkpoint\n");
+        return 1;
+    }
+    if (checkMacro && (target.steps == 0 || checkpointEvery > 0 || trace)){
+        fprintf(stderr, "--check-macro needs --steps and runs without --checkpoint-every or --trace\n");
+        return 1;
+    }
+
+    if (compare && ((params.surfaceCup == 0.0f && params.surfaceArch == 0.0f) || resumePath || checkMacro)){
+        fprintf(stderr, "--compare-flat needs --surface and a run from step 0 without --check-macro\n");
+        return 1;
+    }
+
+    LeafSimulation sim(params);
+    if (resumePath){
+        CheckpointData data;
+        if (!loadCheckpoint(resumePath, data) || !sim.restoreCheckpoint(data)){
+            return 1;
+        }
+        printf("resumed from %s at step %llu\n", resumePath, (unsigned long long)sim.getStep());
+    }
+    StepJournal journal;
+    if (journalPath){
+        CheckpointData base;
+        sim.captureCheckpoint(base);
+        if (!journal.open(journalPath, base)){
+            return 1;
+        }
+        sim.setJournal(&journal);
+    }
+    CheckpointWriter writer;
+    auto start = chrono::steady_clock::now();
+    uint64_t steps = 0;
+    bool macroOk = true;
+    if (checkMacro){
+        uint64_t startStep = sim.getStep();
+        vector<MacroStepError> errors = checkMacroSteps(sim, startStep + target.steps);
+        steps = sim.getStep() - startStep;
+        MacroStepError worst;
+        for (const MacroStepError& e : errors){
+            worst.predicted = max(worst.predicted, e.predicted);
+            worst.margin = max(worst.margin, e.margin);
+            worst.sources = max(worst.sources, e.sources);
+            worst.tree = max(worst.tree, e.tree);
+        }
+        float bound = sim.getParams().macroAreaExcess;
+        macroOk = worst.worst() <= bound;
+        printf("checked %zu macro-steps, largest predicted area excess %g, measured margin %g, "
+               "sources %g, tree %g: %s %g\n", errors.size(), worst.predicted, worst.margin,
+               worst.sources, worst.tree, macroOk ? "within" : "over", bound);
+    }
+    else if (checkpointEvery > 0){
+        // run in legs of checkpointEvery steps; each checkpoint is written
+        // while the next leg runs
+        uint64_t startStep = sim.getStep();
+        while (sim.progressTowards(target, startStep) < 1.0f){
+            RunTarget leg = target;
+            leg.steps = checkpointEvery;
+            if (target.steps > 0){
+                leg.steps = min(leg.steps, startStep + target.steps - sim.getStep());
+            }
+            steps += sim.runUntil(leg);
+            CheckpointData data;
+            sim.captureCheckpoint(data);
+            writer.write(move(data), checkpointPath);
+        }
+    }
+    else if (trace){
+        uint64_t startStep = sim.getStep();
+        for (const StepView& v : stepThrough(sim, target)){
+            printf("step %llu: +%zu segments, %zu sources killed, %zu live, %.3f ms\n",
+                   (unsigned long long)v.step, v.newSegments.size() / 6, v.killedSources.size() / 2,
+                   v.liveSources, v.millis);
+        }
+        steps = sim.getStep() - startStep;
+    }
+    else {
+        steps = sim.runUntil(target);
+    }
+    if (checkpointPath && checkpointEvery == 0){
+        CheckpointData data;
+        sim.captureCheckpoint(data);
+        writer.write(move(data), checkpointPath);
+    }
+    bool checkpointOk = writer.wait();
+    sim.setJournal(nullptr);
+    bool journalOk = journal.close();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    printf("steps: %llu\n", (unsigned long long)steps);
+    printf("nodes: %zu\n", sim.nodeCount());
+    printf("auxin sources: %zu\n", sim.getSources().size());
+    printf("leaf area: %f\n", sim.leafArea());
+    printf("margin vertices: %zu\n", sim.getLeafMargin().size());
+    printf("sampler runs: %lu, skipped: %lu\n", sim.getSchedule().getRuns(), sim.getSchedule().getSkipped());
+    MacroStepController& macro = sim.getMacroController();
+    printf("macro-steps: %lu, increments merged: %lu, max predicted area excess: %g\n",
+           macro.getMacroSteps(), macro.getMergedSteps(), macro.getMaxExcess());
+    StageCounters& counters = sim.getStageCounters();
+    printf("stage runs/skips: sample %lu/%lu, nearest %lu/%lu, place %lu/%lu\n",
+           counters.sampleRuns, counters.sampleSkips, counters.nearestRuns, counters.nearestSkips,
+           counters.placeRuns, counters.placeSkips);
+    printf("idle jumps: %lu covering %lu steps\n", counters.idleJumps, counters.jumpedSteps);
+    printf("time: %.3f s (%.3f ms/step)\n", elapsed.count(), steps ? elapsed.count() * 1e3 / steps : 0.0);
+    printf("critical path time per stage:\n");
+    for (const StageTiming& t : sim.getCriticalTotals()){
+        printf("  %-18s %10.3f ms\n", t.name.c_str(), t.millis);
+    }
+    if (compare){
+        compareFlat(sim, elapsed.count());
+    }
+
+    return writeObj(outPath, sim) && checkpointOk && journalOk && macroOk ? 0 : 1;
+}
@@ -0,0 +1,791 @@
+#include "leafsimulation.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+#include "checkpoint.h"
+#include "journal.h"
+#include "rng.h"
+#include "simdkernels.h"
+#include "snapshot.h"
+
+// sources per chunk of the parallel kill pass; fixed so that results do not
+// depend on the number of threads
+#define NEAREST_CHUNK 256
+
+using namespace std;
+
+static uint64_t hashFloat(uint64_t h, float v){
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return splitMix64(h ^ bits);
+}
+
+// depends only on where a node and its parent are, so the tree hash is the
+// same however the nodes were numbered or visited
+static uint64_t nodeHash(VeinNode* node){
+    uint64_t h = hashFloat(0, node->getX());
+    h = hashFloat(h, node->getY());
+    if (node->getParent()){
+        h = hashFloat(h, node->getParent()->getX());
+        h = hashFloat(h, node->getParent()->getY());
+    }
+    return h;
+}
+
+LeafSimulation::LeafSimulation(const SimulationParams& p):
+    params(p), pool(new ThreadPool(p.threads)), journalStep(new JournalStep()){
+    reset();
+}
+
+LeafSimulation::~LeafSimulation(){
+    deleteTree(petiole);
+}
+
+void LeafSimulation::reset(){
+    deleteTree(petiole);
+    petiole = nullptr;
+    leafMargin.clear();
+    auxinSources.clear();
+    candidateQueue.clear();
+    sourceSchedule.reset();
+    macroController.reset();
+    counters = StageCounters();
+    influencedNodes = 0;
+    lastCriticalPath.clear();
+    criticalTotals.clear();
+    replayNodes.clear();
+    journalStep->clear();
+    addedNodes.clear();
+    killedSources.clear();
+    uniformGrowth = params.initGrowth;
+    marginGrowth = params.initGrowth;
+    unitDist = params.initUnitDist;
+    org_x = org_y = 0.0f;
+    stepCount = 0;
+    drawLeafMargin();
+    fitSurface();
+    nodes = 1;
+    treeHash = nodeHash(petiole);
+}
+
+// the main shape as the first lobe, the petiole's, then the others
+static vector<MarginLobe> outlineLobes(const SimulationParams& p){
+    vector<MarginLobe> lobes(1);
+    lobes[0].shape = p.shape;
+    size_t extra = min<size_t>(p.lobes.size(), MARGIN_INDEX_MAX_RINGS - 1);
+    if (extra < p.lobes.size()){
+        fprintf(stderr, "Warning: only the first %zu of %zu lobes fit in the margin index\n", extra, p.lobes.size());
+    }
+    lobes.insert(lobes.end(), p.lobes.begin(), p.lobes.begin() + extra);
+    return lobes;
+}
+
+void LeafSimulation::drawLeafMargin(){
+    if (params.outlineX.size() >= 3 && params.outlineX.size() == params.outlineY.size()){
+        leafMargin.buildPolygon(params.outlineX, params.outlineY, params.outlinePetiole);
+    }
+    else {
+        leafMargin.build(outlineLobes(params), max<size_t>(params.marginResolution, 2));
+    }
+    size_t p = leafMargin.getPetioleIndex();
+    petiole_x = leafMargin.getX(p) - params.smallChange;
+    petiole_y = leafMargin.getY(p);
+    refineMargin();
+    if (params.marginControls > 0){
+        leafMargin.fitSpline(params.marginControls, 4);
+        refineMargin();
+    }
+    petiole = new VeinNode(petiole_x, petiole_y);
+}
+
+void LeafSimulation::growLeafMargin(int increments){
+    // k increments compound to one scale factor about the petiole; doubles
+    // keep a single increment exactly equal to marginGrowth
+    double factor = 1.0;
+    float tissueBefore = uniformGrowth;
+    for (int k = 0; k < increments; k++){
+        factor *= 1.0 + marginGrowth;
+        uniformGrowth += params.smallChange;
+        marginGrowth += params.smallChange;
+    }
+    if (params.expandTissue){
+        // the tissue really grows, so distances keep their size where the
+        // default shrinks unitDist by the same ratio
+        expandTissue(uniformGrowth / tissueBefore);
+    }
+    else {
+        unitDist = params.initUnitDist * params.initGrowth / uniformGrowth;
+    }
+    // growing a point by `growth` times its distance along the direction
+    // from the petiole is scaling its offset from the petiole
+    float growth = (float)(factor - 1.0);
+    if (params.growthField.isIdentity()){
+        leafMargin.grow(growth, petiole_x, petiole_y);
+        org_x = petiole_x + (1.0f + growth) * (org_x - petiole_x);
+        org_y = petiole_y + (1.0f + growth) * (org_y - petiole_y);
+    }
+    else {
+        growInField(growth);
+    }
+    // petiole coordinates remain constant
+    leafMargin.setPetiole(petiole_x + params.smallChange, petiole_y);
+    leafMargin.updateBounds();
+    refineMargin();
+}
+
+void LeafSimulation::growInField(float growth){
+    // everything is sampled against the bounds from before the pass, so
+    // the margin and the tissue inside it see the same field
+    const GrowthField& field = params.growthField;
+    array<float, 4> box = {leafMargin.getXMin(), leafMargin.getYMin(), leafMargin.getXMax(), leafMargin.getYMax()};
+    if (params.growthFieldSources && !auxinSources.empty()){
+        float* pos = auxinSources.writablePositionData();
+        field.apply(pos, pos + 1, 2, auxinSources.size(), petiole_x, petiole_y, growth, box);
+    }
+    if (params.growthFieldNodes){
+        gatherNodes();
+        field.apply(tissueXs.data(), tissueYs.data(), 1, tissueNodes.size(), petiole_x, petiole_y, growth, box);
+        scatterNodes();
+    }
+    field.apply(&org_x, &org_y, 1, 1, petiole_x, petiole_y, growth, box);
+    leafMargin.grow(field, growth, petiole_x, petiole_y);
+}
+
+void LeafSimulation::expandTissue(float factor){
+    if (factor == 1.0f) return;
+    if (!auxinSources.empty()){
+        scaleAbout(auxinSources.writablePositionData(), 2 * auxinSources.size(), petiole_x, petiole_y, factor);
+    }
+    gatherNodes();
+    scaleAbout(tissueXs.data(), tissueXs.size(), petiole_x, petiole_x, factor);
+    scaleAbout(tissueYs.data(), tissueYs.size(), petiole_y, petiole_y, factor);
+    scatterNodes();
+    candidateQueue.scaleAbout(petiole_x, petiole_y, factor);
+    org_x = petiole_x + factor * (org_x - petiole_x);
+    org_y = petiole_y + factor * (org_y - petiole_y);
+    leafMargin.scale(factor, petiole_x, petiole_y);
+}
+
+void LeafSimulation::gatherNodes(){
+    tissueNodes.clear();
+    vector<VeinNode*> stack = {petiole};
+    while (!stack.empty()){
+        VeinNode* node = stack.back();
+        stack.pop_back();
+        tissueNodes.push_back(node);
+        for (VeinNode* child : node->getChildren()){
+            stack.push_back(child);
+        }
+    }
+    size_t n = tissueNodes.size();
+    tissueXs.resize(n);
+    tissueYs.resize(n);
+    for (size_t i = 0; i < n; i++){
+        tissueXs[i] = tissueNodes[i]->getX();
+        tissueYs[i] = tissueNodes[i]->getY();
+    }
+}
+
+void LeafSimulation::scatterNodes(){
+    for (size_t i = 0; i < tissueNodes.size(); i++){
+        tissueNodes[i]->setPosition(tissueXs[i], tissueYs[i]);
+    }
+    // every segment moved, so the tree hash starts over
+    treeHash = 0;
+    for (VeinNode* node : tissueNodes){
+        treeHash += nodeHash(node);
+    }
+}
+
+void LeafSimulation::fitSurface(){
+    surface.set(params.surfaceCup, params.surfaceArch);
+    surface.fit(petiole_x, petiole_y, leafMargin.getXMax() - leafMargin.getXMin());
+}
+
+void LeafSimulation::refineMargin(){
+    // edge limits follow the source spacing, which shrinks relative to the
+    // leaf as it grows
+    float spacing = params.srcSrcDist * unitDist;
+    leafMargin.refine(params.marginMaxEdge * spacing, params.marginMaxTurn,
+                      params.marginMinEdge * spacing, petiole_x, petiole_y);
+}
+
+DensityFunction LeafSimulation::leafDensity(){
+    // blend from midrib to margin spacing with distance off the midrib (y = 0)
+    float y_max = max(leafMargin.getYMax(), -leafMargin.getYMin());
+    float midrib = params.midribSpacing, margin = params.marginSpacing;
+    return [y_max, midrib, margin](float, float y){
+        float t = min(abs(y) / y_max, 1.0f);
+        return midrib + (margin - midrib) * t;
+    };
+}
+
+void LeafSimulation::genAuxinSources(){
+    // the whole bounding box is sampled as a single tile for now
+    CounterRng rng(params.seed, stepCount, 0);
+    array<float, 2> Xmin = {leafMargin.getXMin(), leafMargin.getYMin()};
+    array<float, 2> Xmax = {leafMargin.getXMax(), leafMargin.getYMax()};
+    AdaptiveSamplerParams sampler;
+    sampler.baseRadius = params.srcSrcDist * unitDist;
+    sampler.minScale = min(params.midribSpacing, params.marginSpacing);
+    sampler.maxScale = max(params.midribSpacing, params.marginSpacing);
+    vector<array<float, 2>> poissonRaw = adaptivePoissonSampling(sampler, leafDensity(), Xmin, Xmax, rng);
+    uint32_t order = 0;
+    for (auto p : poissonRaw){
+        if (leafMargin.inside(p[0], p[1])){
+            candidateQueue.push({p[0], p[1], stepCount, order});
+        }
+        order++;
+    }
+}
+
+void LeafSimulation::admitAuxinSource(const SourceCandidate& c){
+    float x = c.x, y = c.y;
+    float spacing = params.srcSrcDist * unitDist * leafDensity()(x, y);
+    bool flat = surface.isFlat();
+    float z = flat ? 0.0f : surface.height(x, y);
+    for (size_t i = 0; i < auxinSources.size(); i++){
+        float d = flat ? euclidDistance(x, y, auxinSources.getX(i), auxinSources.getY(i))
+                       : surface.distance(x, y, z, auxinSources.getX(i), auxinSources.getY(i));
+        if (d < spacing){
+            return;
+        }
+    }
+    float nodeDist;
+    VeinNode* near = nearestNode(x, y, nodeDist);
+    if (nodeDist > params.srcNodeDist * unitDist){
+        auxinSources.insert(x, y, stepCount, near, nodeDist);
+        sourceSchedule.countAdmitted();
+        if (journal){
+            journalStep->created.push_back(x);
+            journalStep->created.push_back(y);
+        }
+    }
+}
+
+VeinNode* LeafSimulation::nearestNode(float x, float y, float& dist){
+    if (surface.isFlat()){
+        VeinNode* node = findNearestNode(petiole, x, y);
+        dist = euclidDistance(node, x, y);
+        return node;
+    }
+    float z = surface.height(x, y);
+    VeinNode* node = findNearestNode(petiole, x, y, z, surface);
+    dist = surface.distance(x, y, z, node->getX(), node->getY());
+    return node;
+}
+
+void LeafSimulation::findNearestNodes(){
+    // Each chunk of sources finds its nearest nodes in parallel and sums its
+    // unit directions into chunk-local per-node accumulators. The chunks are
+    // then reduced in order, so every node receives the same float sums in
+    // the same order whatever the thread count.
+    struct Accumulator{
+        VeinNode* node;
+        float sum_x, sum_y;
+        int count;
+    };
+    size_t n = auxinSources.size();
+    size_t chunks = (n + NEAREST_CHUNK - 1) / NEAREST_CHUNK;
+    vector<vector<Accumulator>> partials(chunks);
+    killed.assign(n, 0);
+    float killRadius = params.killDist * unitDist;
+    pool->parallelFor(n, NEAREST_CHUNK, [&](size_t begin, size_t end, size_t chunk){
+        vector<Accumulator>& acc = partials[chunk];
+        unordered_map<VeinNode*, size_t> slot;
+        for (size_t i = begin; i < end; i++){
+            float aux_x = auxinSources.getX(i), aux_y = auxinSources.getY(i);
+            float dist;
+            VeinNode* tmp = nearestNode(aux_x, aux_y, dist);
+            auxinSources.setNearest(i, tmp, dist);
+            if (dist <= killRadius){
+                killed[i] = 1;
+                continue;
+            }
+            float dir_x = aux_x - tmp->getX(), dir_y = aux_y - tmp->getY();
+            unitVector(dir_x, dir_y);
+            auto it = slot.find(tmp);
+            if (it == slot.end()){
+                slot[tmp] = acc.size();
+                acc.push_back({tmp, dir_x, dir_y, 1});
+            }
+            else {
+                Accumulator& a = acc[it->second];
+                a.sum_x += dir_x;
+                a.sum_y += dir_y;
+                a.count++;
+            }
+        }
+    });
+    influencedNodes = 0;
+    for (vector<Accumulator>& acc : partials){
+        for (Accumulator& a : acc){
+            a.node->addInfluence(a.sum_x, a.sum_y, a.count);
+        }
+        influencedNodes += acc.size();
+    }
+    // remove back to front: whatever swap-remove moves down has already
+    // been visited
+    for (size_t i = n; i-- > 0;){
+        if (killed[i]){
+            killedSources.push_back(auxinSources.getX(i));
+            killedSources.push_back(auxinSources.getY(i));
+            auxinSources.removeAt(i);
+            if (journal){
+                journalStep->killed.push_back((uint32_t)i);
+            }
+        }
+    }
+}
+
+void LeafSimulation::sampleStage(){
+    bool generate = sourceSchedule.shouldRun(leafArea(), auxinSources.size());
+    if (!generate && candidateQueue.size() == 0){
+        counters.sampleSkips++;
+        return;
+    }
+    counters.sampleRuns++;
+    if (generate){
+        genAuxinSources();
+    }
+    candidateQueue.setBudget(params.candidateBudget, params.candidateMillis);
+    candidateQueue.setMaxAge(params.candidateMaxAge);
+    candidateQueue.process(stepCount, [this](const SourceCandidate& c){ admitAuxinSource(c); });
+}
+
+uint64_t LeafSimulation::incrementsToNextRun(uint64_t limit){
+    // the margin scales about the petiole, so the area grows with the
+    // square of the accumulated factor, which tissue expansion adds to
+    double area = leafArea();
+    double target = sourceSchedule.getNextRunArea();
+    double factor = 1.0;
+    double g = marginGrowth;
+    double u = uniformGrowth;
+    uint64_t k = 0;
+    while (k < limit && area * factor * factor < target){
+        factor *= 1.0 + g;
+        if (params.expandTissue){
+            factor *= (u + params.smallChange) / u;
+        }
+        g += params.smallChange;
+        u += params.smallChange;
+        k++;
+    }
+    return max<uint64_t>(k, 1);
+}
+
+bool LeafSimulation::idleJumpStep(SimSnapshot* snap, uint64_t maxIncrements){
+    // Nothing live, nothing queued and the sampler not due, which with
+    // nothing live means the last run admitted nothing: every step until it
+    // is due would only grow the margin, so do all of that growth at once.
+    if (!params.idleJump || !auxinSources.empty() || candidateQueue.size() > 0
+        || sourceSchedule.wouldRun(leafArea(), 0)){
+        return false;
+    }
+    uint64_t limit = params.maxIdleJump;
+    if (maxIncrements > 0){
+        limit = min(limit, maxIncrements);
+    }
+    uint64_t k = incrementsToNextRun(limit);
+    addedNodes.clear();
+    killedSources.clear();
+    growLeafMargin((int)k);
+    stepCount += k;
+    sourceSchedule.skip(k);
+    counters.sampleSkips += k;
+    counters.nearestSkips += k;
+    counters.placeSkips += k;
+    counters.idleJumps++;
+    counters.jumpedSteps += k;
+    recordStep(k);
+    if (snap){
+        fillSnapshot(*snap);
+    }
+    return true;
+}
+
+void LeafSimulation::step(SimSnapshot* snap, uint64_t maxIncrements){
+    // sample -> nearest -> place -> (veins and sources snapshots)
+    //                  \-> grow  -> (margin snapshot)
+    // Placement only touches the tree and growth only the margin and
+    // growth scalars, so the two overlap once the kill pass is done. The
+    // snapshots overlap the rest of this step but not the next one's
+    // sample, since run() waits for them and sampling inserts into the
+    // sources they copy.
+    sourceSchedule.setAreaFraction(params.scheduleAreaFraction);
+    sourceSchedule.setMinLiveSources(params.scheduleMinLiveSources);
+    fitSurface();
+    if (idleJumpStep(snap, maxIncrements)){
+        return;
+    }
+    macroController.configure(params.macroMaxSteps, params.macroAreaExcess, params.macroActivityThreshold);
+    // single steps would sample as soon as it is due, so a merged step must
+    // not run past that
+    uint64_t untilSample = 1;
+    if (params.macroMaxSteps > 1 && !sourceSchedule.wouldRun(leafArea(), auxinSources.size())){
+        untilSample = incrementsToNextRun(params.macroMaxSteps);
+    }
+    int increments = macroController.choose(marginGrowth, params.smallChange,
+                                            auxinSources.size(), candidateQueue.size(), untilSample);
+    if (maxIncrements > 0 && (uint64_t)increments > maxIncrements){
+        increments = (int)maxIncrements;
+    }
+
+    stepGraph.clear();
+    int sample = stepGraph.add("sample", [this]{ sampleStage(); });
+    int nearest = stepGraph.add("nearest", [this]{
+        influencedNodes = 0;
+        killedSources.clear();
+        if (auxinSources.empty()){
+            counters.nearestSkips++;
+            return;
+        }
+        counters.nearestRuns++;
+        findNearestNodes();
+    }, {sample});
+    int place = stepGraph.add("place", [this]{
+        addedNodes.clear();
+        if (influencedNodes == 0){
+            counters.placeSkips++;
+            return;
+        }
+        counters.placeRuns++;
+        placeNewNodes(petiole, params.nodeNodeDist, &addedNodes, surface.isFlat() ? nullptr : &surface);
+        for (VeinNode* node : addedNodes){
+            node->setId((uint32_t)nodes++);
+            treeHash += nodeHash(node);
+            if (journal){
+                journalStep->added.push_back({node->getParent()->getId(), node->getX(), node->getY()});
+            }
+        }
+    }, {nearest});
+    // growth that moves sources or nodes has to wait for placement, and
+    // the snapshots for it
+    bool carried = params.expandTissue
+        || (!params.growthField.isIdentity() && (params.growthFieldSources || params.growthFieldNodes));
+    int grow = stepGraph.add("grow", [this, increments]{ growLeafMargin(increments); }, {carried ? place : nearest});
+    if (snap){
+        stepGraph.add("snapshot sources", [this, snap]{
+            snap->sources.assign(auxinSources.positionData(), auxinSources.positionData() + 2 * auxinSources.size());
+            snap->samplerRuns = sourceSchedule.getRuns();
+            snap->samplerSkipped = sourceSchedule.getSkipped();
+            snap->pendingCandidates = candidateQueue.size();
+            snap->mergedIncrements = macroController.getMergedSteps();
+            snap->skippedStages = counters.skipped();
+        }, {carried ? grow : nearest, place}); // place updates the counters
+        stepGraph.add("snapshot veins", [this, snap]{
+            flattenNodes(snap->segments);
+            snap->nodeCount = snap->segments.size() / 6 + 1;
+        }, {carried ? grow : place});
+        stepGraph.add("snapshot margin", [this, snap]{
+            leafMargin.fillCoords(snap->margin, snap->marginRings, params.marginDrawSamples);
+            surface.lift(snap->margin);
+        }, {grow});
+    }
+    stepGraph.run(*pool);
+    stepCount += increments;
+    recordStep(increments);
+    if (snap){
+        snap->step = stepCount;
+    }
+
+    lastCriticalPath = stepGraph.criticalPath();
+    for (StageTiming& t : lastCriticalPath){
+        bool found = false;
+        for (StageTiming& total : criticalTotals){
+            if (total.name == t.name){
+                total.millis += t.millis;
+                found = true;
+                break;
+            }
+        }
+        if (!found){
+            criticalTotals.push_back(t);
+        }
+    }
+}
+
+void LeafSimulation::recordStep(uint64_t increments){
+    if (!journal) return;
+    journalStep->step = stepCount;
+    journalStep->increments = (uint32_t)increments;
+    journalStep->hash = stateHash();
+    journal->record(*journalStep);
+    journalStep->clear();
+}
+
+void LeafSimulation::setJournal(StepJournal* j){
+    journal = j;
+    journalStep->clear();
+}
+
+uint64_t LeafSimulation::stateHash(){
+    uint64_t h = splitMix64(stepCount);
+    for (size_t i = 0; i < leafMargin.size(); i++){
+        h = hashFloat(h, leafMargin.getX(i));
+        h = hashFloat(h, leafMargin.getY(i));
+    }
+    const float* pos = auxinSources.positionData();
+    for (size_t i = 0; i < 2 * auxinSources.size(); i++){
+        h = hashFloat(h, pos[i]);
+    }
+    h = splitMix64(h ^ nodes);
+    return splitMix64(h ^ treeHash);
+}
+
+bool LeafSimulation::applyJournalStep(const JournalStep& s){
+    fitSurface();
+    if (replayNodes.size() != nodes){
+        replayNodes.assign(nodes, nullptr);
+        vector<VeinNode*> stack = {petiole};
+        while (!stack.empty()){
+            VeinNode* node = stack.back();
+            stack.pop_back();
+            if (node->getId() >= nodes){
+                return false;
+            }
+            replayNodes[node->getId()] = node;
+            stack.insert(stack.end(), node->getChildren().begin(), node->getChildren().end());
+        }
+    }
+    if (s.step != stepCount + s.increments){
+        return false;
+    }
+    for (size_t i = 0; i < s.created.size(); i += 2){
+        auxinSources.insert(s.created[i], s.created[i+1], stepCount);
+    }
+    for (uint32_t i : s.killed){
+        if (i >= auxinSources.size()){
+            return false;
+        }
+        auxinSources.removeAt(i);
+    }
+    for (const JournalNode& n : s.added){
+        if (n.parent >= replayNodes.size()){
+            return false;
+        }
+        VeinNode* node = replayNodes[n.parent]->addChild(n.x, n.y);
+        node->setId((uint32_t)nodes++);
+        treeHash += nodeHash(node);
+        replayNodes.push_back(node);
+    }
+    growLeafMargin((int)s.increments);
+    stepCount = s.step;
+    return true;
+}
+
+float LeafSimulation::leafArea(){
+    return leafMargin.area();
+}
+
+float LeafSimulation::progressTowards(const RunTarget& target, uint64_t startStep){
+    float progress = 0.0f;
+    bool any = false;
+    if (target.steps > 0){
+        progress = max(progress, (float)(stepCount - startStep) / target.steps);
+        any = true;
+    }
+    if (target.nodeCount > 0){
+        progress = max(progress, (float)nodes / target.nodeCount);
+        any = true;
+    }
+    if (target.leafArea > 0.0f){
+        progress = max(progress, leafArea() / target.leafArea);
+        any = true;
+    }
+    return any ? min(progress, 1.0f) : 1.0f;
+}
+
+uint64_t LeafSimulation::runUntil(const RunTarget& target, const function<bool()>& cancel){
+    uint64_t start = stepCount;
+    while (progressTowards(target, start) < 1.0f){
+        if (cancel && cancel()) break;
+        uint64_t remaining = 0;
+        if (target.steps > 0){
+            remaining = start + target.steps - stepCount;
+        }
+        step(nullptr, remaining);
+    }
+    return stepCount - start;
+}
+
+void LeafSimulation::flattenNodes(vector<float>& nodePos){
+    nodePos.clear();
+    flattenTree(petiole, nodePos);
+    if (!surface.isFlat()){
+        surface.lift(nodePos);
+    }
+}
+
+void LeafSimulation::fillSnapshot(SimSnapshot& snap){
+    snap.step = stepCount;
+    leafMargin.fillCoords(snap.margin, snap.marginRings, params.marginDrawSamples);
+    surface.lift(snap.margin);
+    snap.sources.assign(auxinSources.positionData(), auxinSources.positionData() + 2 * auxinSources.size());
+    flattenNodes(snap.segments);
+    snap.nodeCount = snap.segments.size() / 6 + 1;
+    snap.samplerRuns = sourceSchedule.getRuns();
+    snap.samplerSkipped = sourceSchedule.getSkipped();
+    snap.pendingCandidates = candidateQueue.size();
+    snap.mergedIncrements = macroController.getMergedSteps();
+    snap.skippedStages = counters.skipped();
+}
+
+void LeafSimulation::captureCheckpoint(CheckpointData& data){
+    data.params = params;
+    data.stepCount = stepCount;
+    data.nodes = nodes;
+    data.uniformGrowth = uniformGrowth;
+    data.marginGrowth = marginGrowth;
+    data.unitDist = unitDist;
+    data.petiole_x = petiole_x;
+    data.petiole_y = petiole_y;
+    data.org_x = org_x;
+    data.org_y = org_y;
+    data.scheduleLastArea = sourceSchedule.getLastArea();
+    data.scheduleHasRun = sourceSchedule.getHasRun();
+    data.scheduleRuns = sourceSchedule.getRuns();
+    data.scheduleSkipped = sourceSchedule.getSkipped();
+    data.scheduleAdmitted = sourceSchedule.getAdmitted();
+    data.marginX = leafMargin.getXs();
+    data.marginY = leafMargin.getYs();
+    data.marginAngles = leafMargin.getAngles();
+    data.marginRates = leafMargin.getRates();
+    data.marginScales = leafMargin.getScales();
+    data.marginPetiole = leafMargin.getPetioleIndex();
+    data.marginOnCurve = leafMargin.isOnCurve();
+    data.marginSplineSamples = leafMargin.isSpline() ? leafMargin.getSpanSamples() : 0;
+    data.marginLobes = leafMargin.getLobes();
+    data.marginRings.assign(leafMargin.getRings().begin(), leafMargin.getRings().end());
+
+    // only the nodes some source points at need their index looked up
+    size_t n = auxinSources.size();
+    unordered_map<VeinNode*, int32_t> nearestIndex;
+    for (size_t i = 0; i < n; i++){
+        nearestIndex[auxinSources.getNearest(i)] = -1;
+    }
+    data.nodeX.clear();
+    data.nodeY.clear();
+    data.nodeParent.clear();
+    data.nodeX.reserve(nodes);
+    data.nodeY.reserve(nodes);
+    data.nodeParent.reserve(nodes);
+    // preorder without recursion, the tree can be as deep as it is large
+    vector<pair<VeinNode*, int32_t>> stack;
+    if (petiole){
+        stack.push_back({petiole, -1});
+    }
+    while (!stack.empty()){
+        VeinNode* node = stack.back().first;
+        int32_t parent = stack.back().second;
+        stack.pop_back();
+        int32_t index = (int32_t)data.nodeX.size();
+        data.nodeX.push_back(node->getX());
+        data.nodeY.push_back(node->getY());
+        data.nodeParent.push_back(parent);
+        auto it = nearestIndex.find(node);
+        if (it != nearestIndex.end()){
+            it->second = index;
+        }
+        const vector<VeinNode*>& children = node->getChildren();
+        for (size_t c = children.size(); c-- > 0;){
+            stack.push_back({children[c], index});
+        }
+    }
+
+    data.sourcePos.assign(auxinSources.positionData(), auxinSources.positionData() + 2 * n);
+    data.sourceBirth.resize(n);
+    data.sourceNearest.resize(n);
+    data.sourceDist.resize(n);
+    for (size_t i = 0; i < n; i++){
+        data.sourceBirth[i] = auxinSources.getBirthStep(i);
+        data.sourceNearest[i] = nearestIndex[auxinSources.getNearest(i)];
+        data.sourceDist[i] = auxinSources.getNearestDist(i);
+    }
+    data.candidates = candidateQueue.contents();
+    data.candidatesDropped = candidateQueue.getDropped();
+    data.macroSteps = macroController.getMacroSteps();
+    data.mergedSteps = macroController.getMergedSteps();
+    data.macroMaxExcess = macroController.getMaxExcess();
+    data.counters = counters;
+}
+
+bool LeafSimulation::restoreCheckpoint(const CheckpointData& data){
+    size_t nodeCount = data.nodeX.size();
+    size_t n = data.sourceBirth.size();
+    bool valid = nodeCount > 0 && data.nodes == nodeCount && data.nodeY.size() == nodeCount && data.nodeParent.size() == nodeCount
+        && data.nodeParent[0] == -1 && data.sourcePos.size() == 2 * n && data.sourceNearest.size() == n
+        && data.sourceDist.size() == n;
+    size_t m = data.marginAngles.size();
+    valid = valid && m >= 3 && data.marginX.size() == m && data.marginY.size() == m
+        && data.marginRates.size() == m && data.marginScales.size() == m && data.marginPetiole < m;
+    // an imported outline is one ring with no lobes
+    size_t lobes = data.marginLobes.empty() ? 1 : data.marginLobes.size();
+    valid = valid && (!data.marginLobes.empty() || !data.marginOnCurve) && lobes <= MARGIN_INDEX_MAX_RINGS
+        && data.marginRings.size() == lobes + 1 && data.marginRings[0] == 0 && data.marginRings[lobes] == m
+        && data.marginSplineSamples <= 64 && (data.marginSplineSamples == 0 || !data.marginOnCurve);
+    for (size_t k = 0; valid && k < lobes; k++){
+        valid = data.marginRings[k + 1] >= data.marginRings[k] + 3;
+    }
+    for (size_t i = 1; valid && i < nodeCount; i++){
+        valid = data.nodeParent[i] >= 0 && (size_t)data.nodeParent[i] < i;
+    }
+    for (size_t i = 0; valid && i < n; i++){
+        valid = data.sourceNearest[i] >= 0 && (size_t)data.sourceNearest[i] < nodeCount;
+    }
+    if (!valid){
+        fprintf(stderr, "Error: inconsistent checkpoint data\n");
+        return false;
+    }
+
+    size_t threads = params.threads;
+    params = data.params;
+    params.threads = threads; // the pool is kept, and results do not depend on it
+    deleteTree(petiole);
+    vector<VeinNode*> byIndex(nodeCount);
+    byIndex[0] = petiole = new VeinNode(data.nodeX[0], data.nodeY[0]);
+    treeHash = nodeHash(petiole);
+    for (size_t i = 1; i < nodeCount; i++){
+        byIndex[i] = byIndex[data.nodeParent[i]]->addChild(data.nodeX[i], data.nodeY[i]);
+        byIndex[i]->setId((uint32_t)i);
+        treeHash += nodeHash(byIndex[i]);
+    }
+    nodes = data.nodes;
+    stepCount = data.stepCount;
+    uniformGrowth = data.uniformGrowth;
+    marginGrowth = data.marginGrowth;
+    unitDist = data.unitDist;
+    petiole_x = data.petiole_x;
+    petiole_y = data.petiole_y;
+    org_x = data.org_x;
+    org_y = data.org_y;
+    vector<size_t> rings(data.marginRings.begin(), data.marginRings.end());
+    leafMargin.restore(data.marginLobes, rings, data.marginX, data.marginY, data.marginAngles, data.marginRates,
+                       data.marginScales, data.marginPetiole, data.marginOnCurve, data.marginSplineSamples);
+    sourceSchedule.restore(data.scheduleLastArea, data.scheduleHasRun, data.scheduleRuns, data.scheduleSkipped,
+                           data.scheduleAdmitted);
+
+    auxinSources.clear();
+    for (size_t i = 0; i < n; i++){
+        auxinSources.insert(data.sourcePos[2*i], data.sourcePos[2*i+1], data.sourceBirth[i],
+                            byIndex[data.sourceNearest[i]], data.sourceDist[i]);
+    }
+    candidateQueue.restore(data.candidates, data.candidatesDropped);
+    macroController.reset();
+    macroController.restore(data.macroSteps, data.mergedSteps, data.macroMaxExcess);
+    counters = data.counters;
+    influencedNodes = 0;
+    lastCriticalPath.clear();
+    criticalTotals.clear();
+    replayNodes.clear();
+    journalStep->clear();
+    addedNodes.clear();
+    killedSources.clear();
+    fitSurface();
+    return true;
+}
\ No newline at end of file
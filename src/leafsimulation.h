@@ -0,0 +1,238 @@
+#ifndef LEAF_SIMULATION_H
+#define LEAF_SIMULATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "veinnode.h"
+#include "auxinstore.h"
+#include "schedule.h"
+#include "adaptivesampler.h"
+#include "candidatequeue.h"
+#include "threadpool.h"
+#include "taskgraph.h"
+#include "macrostep.h"
+#include "margin.h"
+#include "growthfield.h"
+#include "leafsurface.h"
+#include "superformula.h"
+
+struct SimSnapshot;
+struct CheckpointData;
+struct JournalStep;
+class StepJournal;
+
+struct SimulationParams{
+    uint64_t seed = 1; // every random draw is keyed by (seed, step, tile)
+    float initGrowth = 1e-3f;
+    float smallChange = 1e-6f; // change in growth per step
+    float srcSrcDist = 1.0f;
+    float srcNodeDist = 1.0f;
+    float nodeNodeDist = 1.0f;
+    float killDist = 1.0f;
+    float initUnitDist = 1.0f;
+    float midribSpacing = 1.0f; // source spacing multiplier along the midrib
+    float marginSpacing = 1.0f; // ... and at the widest point of the blade
+    size_t candidateBudget = 0; // candidates admitted per step, 0 = all
+    double candidateMillis = 0.0; // time spent admitting per step, 0 = unlimited
+    uint64_t candidateMaxAge = 50; // older batches have been resampled by then
+    float scheduleAreaFraction = 0.01f;
+    size_t scheduleMinLiveSources = 8;
+    size_t threads = 0; // worker threads, 0 = hardware concurrency
+    size_t macroMaxSteps = 1; // growth increments one quiet step may merge, 1 = off
+    float macroAreaExcess = 0.01f; // bound on a macro-step's predicted extra leaf area, see MacroStepController
+    size_t macroActivityThreshold = 0; // live sources / pending candidates still considered quiet
+    bool idleJump = true; // with no venation work, grow straight to the next sampler run
+    uint64_t maxIdleJump = 100000;
+    Superformula shape; // leaf outline, takes effect on reset()
+    std::vector<MarginLobe> lobes; // further lobes joined to `shape`, also on reset()
+    std::vector<float> outlineX, outlineY; // digitised outline replacing the lobes when not empty
+    size_t outlinePetiole = 0;             // ... and its petiole vertex
+    size_t marginControls = 0;    // > 0: B-spline margin with this many control points per lobe
+    size_t marginDrawSamples = 8; // ... drawn at this many points per span
+    size_t marginResolution = 100; // initial margin vertices per half turn
+    float marginMaxEdge = 2.0f;  // longest margin edge, in source spacings; 0 = no limit
+    float marginMinEdge = 0.25f; // ... and shortest edge curvature may still split
+    float marginMaxTurn = 0.3f;  // radians a margin vertex may turn by; 0 = no limit
+    GrowthField growthField;         // local growth over the leaf, identity = uniform
+    bool growthFieldSources = true;  // the field also carries live sources
+    bool growthFieldNodes = false;   // ... and the vein tree
+    float surfaceCup = 0.0f;  // blade curvature across the midrib, 0 = flat
+    float surfaceArch = 0.0f; // ... and along it
+    bool expandTissue = false; // grow by moving sources, nodes and margin apart instead of shrinking unitDist
+};
+
+// How often each venation stage had work to do and how often it was
+// skipped; an idle jump counts as skipping every stage for every step it
+// covers.
+struct StageCounters{
+    unsigned long sampleRuns = 0, sampleSkips = 0;
+    unsigned long nearestRuns = 0, nearestSkips = 0;
+    unsigned long placeRuns = 0, placeSkips = 0;
+    unsigned long idleJumps = 0, jumpedSteps = 0;
+    unsigned long skipped(){
+        return sampleSkips + nearestSkips + placeSkips;
+    }
+};
+
+// Stop conditions for a run; zero fields are ignored and the run ends as
+// soon as any of the others is met.
+struct RunTarget{
+    uint64_t steps = 0;    // advance by this many steps
+    size_t nodeCount = 0;  // ... or until the tree has this many nodes
+    float leafArea = 0.0f; // ... or until the leaf is this large
+};
+
+// The whole venation model: leaf margin, auxin sources and vein tree, with
+// no dependency on a window or GL context. step() advances it by one frame
+// of the original render loop.
+class LeafSimulation{
+    private:
+        SimulationParams params;
+        LeafMargin leafMargin;
+        LeafSurface surface; // fitted to the leaf at the start of each step
+        AuxinStore auxinSources;
+        float uniformGrowth; // simulate growth throughout leaf
+        float marginGrowth;  // simulate leaf margin growth
+        float unitDist;
+        float petiole_x = 0.0f, petiole_y = 0.0f;
+        float org_x = 0.0f, org_y = 0.0f; // transformed origin
+        VeinNode* petiole = nullptr;
+        uint64_t stepCount = 0;
+        size_t nodes = 0;
+        SourceSchedule sourceSchedule;
+        CandidateQueue candidateQueue;
+        MacroStepController macroController;
+        StageCounters counters;
+        size_t influencedNodes = 0; // nodes given a direction by the last kill pass
+        std::unique_ptr<ThreadPool> pool;
+        std::vector<unsigned char> killed; // per-source flag of the kill pass
+        TaskGraph stepGraph;
+        std::vector<StageTiming> lastCriticalPath;
+        std::vector<StageTiming> criticalTotals; // per stage, summed over steps
+        std::vector<VeinNode*> addedNodes; // placed by the last step
+        std::vector<float> killedSources;  // x, y of the sources the last step killed
+        uint64_t treeHash = 0; // sum of per-node hashes, independent of order
+        StepJournal* journal = nullptr;
+        std::unique_ptr<JournalStep> journalStep;
+        std::vector<VeinNode*> replayNodes; // by id, built on the first replayed step
+        std::vector<VeinNode*> tissueNodes; // scratch for moving the whole tree
+        std::vector<float> tissueXs, tissueYs;
+
+        void drawLeafMargin();
+        void growLeafMargin(int increments = 1);
+        void growInField(float growth);
+        void expandTissue(float factor);
+        void gatherNodes();
+        void scatterNodes();
+        void refineMargin();
+        void fitSurface();
+        VeinNode* nearestNode(float x, float y, float& dist);
+        DensityFunction leafDensity();
+        void genAuxinSources();
+        void admitAuxinSource(const SourceCandidate& c);
+        void findNearestNodes();
+        void sampleStage();
+        uint64_t incrementsToNextRun(uint64_t limit);
+        bool idleJumpStep(SimSnapshot* snap, uint64_t maxIncrements);
+        void recordStep(uint64_t increments);
+    public:
+        explicit LeafSimulation(const SimulationParams& p = SimulationParams());
+        ~LeafSimulation();
+        LeafSimulation(const LeafSimulation&) = delete;
+        LeafSimulation& operator=(const LeafSimulation&) = delete;
+
+        // one step, run as a task graph on the pool; when `snap` is given
+        // it is filled with the post-step state as part of the same graph.
+        // A quiet step may merge several growth increments (see
+        // MacroStepController), advancing getStep() by more than one, and
+        // a step with no venation work at all jumps straight to the next
+        // sampler run. maxIncrements caps the advance, 0 = no cap.
+        void step(SimSnapshot* snap = nullptr, uint64_t maxIncrements = 0);
+        void reset();
+
+        // parameters may be tweaked between steps
+        SimulationParams& getParams(){
+            return params;
+        }
+        uint64_t getStep(){
+            return stepCount;
+        }
+        const LeafSurface& getSurface(){
+            return surface;
+        }
+        LeafMargin& getLeafMargin(){
+            return leafMargin;
+        }
+        AuxinStore& getSources(){
+            return auxinSources;
+        }
+        VeinNode* getPetiole(){
+            return petiole;
+        }
+        SourceSchedule& getSchedule(){
+            return sourceSchedule;
+        }
+        CandidateQueue& getCandidateQueue(){
+            return candidateQueue;
+        }
+        MacroStepController& getMacroController(){
+            return macroController;
+        }
+        StageCounters& getStageCounters(){
+            return counters;
+        }
+        float getUnitDist(){
+            return unitDist;
+        }
+        // stages on the longest dependency chain of the last step
+        const std::vector<StageTiming>& getCriticalPath(){
+            return lastCriticalPath;
+        }
+        // time each stage has spent on the critical path so far
+        const std::vector<StageTiming>& getCriticalTotals(){
+            return criticalTotals;
+        }
+        float leafArea();
+        size_t nodeCount(){
+            return nodes;
+        }
+        // fraction of the way to the nearest target of a run that started at
+        // `startStep`; 1 once it is reached
+        float progressTowards(const RunTarget& target, uint64_t startStep);
+        // steps until the target is reached or `cancel` returns true, and
+        // returns the number of steps taken
+        uint64_t runUntil(const RunTarget& target, const std::function<bool()>& cancel = nullptr);
+        // vein segments as line-list vertices (x, y, z per endpoint)
+        void flattenNodes(std::vector<float>& nodePos);
+        // nodes placed and sources killed by the last step
+        const std::vector<VeinNode*>& getAddedNodes(){
+            return addedNodes;
+        }
+        const std::vector<float>& getKilledSources(){
+            return killedSources;
+        }
+        // copies the drawable state, reusing the snapshot's buffers
+        void fillSnapshot(SimSnapshot& snap);
+        // copies the full state between steps; the copy can then be written
+        // out while the simulation carries on
+        void captureCheckpoint(CheckpointData& data);
+        // replaces the state with a captured one, keeping the thread pool;
+        // returns false (and leaves the state alone) if the data is invalid
+        bool restoreCheckpoint(const CheckpointData& data);
+        // records every following step into `j` (nullptr stops recording)
+        void setJournal(StepJournal* j);
+        // hash of step count, margin, sources and vein tree
+        uint64_t stateHash();
+        // redoes a recorded step from its events alone: no sampling, no
+        // nearest-node search. Only the margin, sources and tree are
+        // rebuilt, so a replayed simulation should not be stepped further.
+        // Returns false if the record does not fit the current state.
+        bool applyJournalStep(const JournalStep& s);
+};
+
+
+#endif
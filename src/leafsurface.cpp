@@ -0,0 +1,56 @@
+#include "leafsurface.h"
+
+#include <algorithm>
+
+#include "margin.h"
+
+using namespace std;
+
+void LeafSurface::fit(float px, float py, float leafLength){
+    base_x = px;
+    base_y = py;
+    length = max(leafLength, 1e-6f);
+    invLength = 1.0f / length;
+}
+
+float LeafSurface::stepScale(float x, float y, float dx, float dy) const {
+    // slope of the height field along (dx, dy)
+    float u = (x - base_x) * invLength, v = (y - base_y) * invLength;
+    float slope = 2.0f * (arch * u * dx + cup * v * dy);
+    return 1.0f / sqrt(1.0f + slope * slope);
+}
+
+void LeafSurface::lift(vector<float>& xyz) const {
+    for (size_t i = 0; i + 2 < xyz.size(); i += 3){
+        xyz[i+2] = height(xyz[i], xyz[i+1]);
+    }
+}
+
+void LeafSurface::triangulate(LeafMargin& margin, int cells, vector<float>& xyz,
+                              vector<uint32_t>& triangles) const {
+    xyz.clear();
+    triangles.clear();
+    if (cells < 1 || margin.size() < 3) return;
+    float x0 = margin.getXMin(), y0 = margin.getYMin();
+    float sx = (margin.getXMax() - x0) / cells, sy = (margin.getYMax() - y0) / cells;
+    for (int j = 0; j <= cells; j++){
+        for (int i = 0; i <= cells; i++){
+            float x = x0 + i * sx, y = y0 + j * sy;
+            xyz.insert(xyz.end(), {x, y, height(x, y)});
+        }
+    }
+    for (int j = 0; j < cells; j++){
+        for (int i = 0; i < cells; i++){
+            uint32_t a = j * (cells + 1) + i, b = a + 1, c = a + cells + 1, d = c + 1;
+            float x = x0 + (i + 1.0f / 3) * sx, y = y0 + (j + 1.0f / 3) * sy;
+            if (margin.inside(x, y)){
+                triangles.insert(triangles.end(), {a, b, c});
+            }
+            x = x0 + (i + 2.0f / 3) * sx;
+            y = y0 + (j + 2.0f / 3) * sy;
+            if (margin.inside(x, y)){
+                triangles.insert(triangles.end(), {b, d, c});
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef LEAF_SURFACE_H
+#define LEAF_SURFACE_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+class LeafMargin;
+
+// Curved leaf blade as a height field over the flat (x, y) coordinates the
+// simulation works in:
+//     z = L * (arch * u^2 + cup * v^2)
+// with u, v the offset from the petiole in leaf lengths L, so the blade
+// keeps its shape as it grows. Distances are chords through the surface,
+// within O(curvature^2 d^3) of the geodesic at vein spacing, for the cost
+// of two height evaluations.
+class LeafSurface{
+    private:
+        float cup = 0.0f, arch = 0.0f;
+        float base_x = 0.0f, base_y = 0.0f;
+        float length = 1.0f, invLength = 1.0f;
+    public:
+        void set(float cupping, float arching){
+            cup = cupping;
+            arch = arching;
+        }
+        // re-fits the surface to a leaf of `leafLength` grown from (px, py)
+        void fit(float px, float py, float leafLength);
+        bool isFlat() const {
+            return cup == 0.0f && arch == 0.0f;
+        }
+        float height(float x, float y) const {
+            float u = (x - base_x) * invLength, v = (y - base_y) * invLength;
+            return length * (arch * u * u + cup * v * v);
+        }
+        // from (x1, y1) at height z1 to (x2, y2) on the surface
+        float distance(float x1, float y1, float z1, float x2, float y2) const {
+            float dx = x2 - x1, dy = y2 - y1, dz = height(x2, y2) - z1;
+            return std::sqrt(dx * dx + dy * dy + dz * dz);
+        }
+        float distance(float x1, float y1, float x2, float y2) const {
+            return distance(x1, y1, height(x1, y1), x2, y2);
+        }
+        // how far to move in the plane along the unit (dx, dy) from (x, y)
+        // for each unit travelled on the surface
+        float stepScale(float x, float y, float dx, float dy) const;
+        // replaces every third value of x, y, z triples by the height
+        void lift(std::vector<float>& xyz) const;
+        // grid of `cells` x `cells` over the margin's bounds, keeping the
+        // triangles whose centre lies inside it; vertices as x, y, z
+        void triangulate(LeafMargin& margin, int cells, std::vector<float>& xyz,
+                         std::vector<uint32_t>& triangles) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "macrocheck.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "checkpoint.h"
+
+using namespace std;
+
+// Pairs of points of `a` and `b`, `dim` floats each, within `tol` in every
+// coordinate, each point used at most once: the tree stacks many nodes on
+// the same spot, so it has to be compared as a multiset. `b` must be sorted
+// by its first coordinate.
+static size_t matched(const vector<float>& a, const vector<float>& b, size_t dim, float tol){
+    size_t count = 0, nb = b.size() / dim;
+    vector<bool> used(nb, false);
+    for (size_t i = 0; i < a.size(); i += dim){
+        // first point of b whose leading coordinate is within reach
+        size_t lo = 0, hi = nb;
+        while (lo < hi){
+            size_t mid = (lo + hi) / 2;
+            if (b[mid * dim] < a[i] - tol) lo = mid + 1;
+            else hi = mid;
+        }
+        for (size_t j = lo; j < nb && b[j * dim] <= a[i] + tol; j++){
+            if (used[j]) continue;
+            bool found = true;
+            for (size_t d = 1; d < dim && found; d++){
+                found = fabs(b[j * dim + d] - a[i + d]) <= tol;
+            }
+            if (found){
+                used[j] = true;
+                count++;
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+static void sortPoints(vector<float>& v, size_t dim){
+    size_t n = v.size() / dim;
+    vector<size_t> order(n);
+    for (size_t i = 0; i < n; i++) order[i] = i;
+    sort(order.begin(), order.end(), [&](size_t p, size_t q){ return v[p * dim] < v[q * dim]; });
+    vector<float> sorted(v.size());
+    for (size_t i = 0; i < n; i++){
+        copy(v.begin() + order[i] * dim, v.begin() + (order[i] + 1) * dim, sorted.begin() + i * dim);
+    }
+    v.swap(sorted);
+}
+
+// share of the points left unpaired between the two sets
+static float setDifference(vector<float> a, vector<float> b, size_t dim, float tol){
+    if (a.empty() && b.empty()) return 0.0f;
+    sortPoints(a, dim);
+    sortPoints(b, dim);
+    size_t total = (a.size() + b.size()) / dim;
+    size_t missing = total - 2 * matched(a, b, dim, tol);
+    return (float)missing / total;
+}
+
+// largest distance from points on `a`'s margin to `b`'s
+static float marginGap(LeafMargin& a, LeafMargin& b){
+    vector<float> coords;
+    vector<int> rings;
+    a.fillCoords(coords, rings, 4);
+    float gap = 0.0f;
+    for (size_t i = 0; i < coords.size(); i += 3){
+        gap = max(gap, fabs(b.signedDistance(coords[i], coords[i + 1])));
+    }
+    return gap;
+}
+
+// segments as x, y of parent then child, without the surface's z
+static vector<float> segments2d(LeafSimulation& sim){
+    vector<float> segments, flat;
+    sim.flattenNodes(segments);
+    for (size_t i = 0; i < segments.size(); i += 3){
+        flat.push_back(segments[i]);
+        flat.push_back(segments[i + 1]);
+    }
+    return flat;
+}
+
+vector<MacroStepError> checkMacroSteps(LeafSimulation& sim, uint64_t until){
+    vector<MacroStepError> errors;
+    LeafSimulation single(sim.getParams());
+    MacroStepController& macro = sim.getMacroController();
+    while (sim.getStep() < until){
+        CheckpointData before;
+        sim.captureCheckpoint(before);
+        unsigned long macroSteps = macro.getMacroSteps();
+        sim.step(nullptr, until - sim.getStep());
+        if (macro.getMacroSteps() == macroSteps) continue;
+
+        MacroStepError error;
+        error.step = before.stepCount;
+        error.increments = sim.getStep() - before.stepCount;
+        error.predicted = macro.getLastExcess();
+        if (!single.restoreCheckpoint(before)) break;
+        single.getParams().macroMaxSteps = 1;
+        single.getParams().idleJump = false;
+        while (single.getStep() < sim.getStep()){
+            single.step(nullptr, sim.getStep() - single.getStep());
+        }
+        LeafMargin& a = sim.getLeafMargin();
+        LeafMargin& b = single.getLeafMargin();
+        float width = max(a.getXMax() - a.getXMin(), a.getYMax() - a.getYMin());
+        float tol = 1e-4f * width;
+        error.margin = max(marginGap(a, b), marginGap(b, a)) / width;
+        AuxinStore& sa = sim.getSources();
+        AuxinStore& sb = single.getSources();
+        error.sources = setDifference(vector<float>(sa.positionData(), sa.positionData() + 2 * sa.size()),
+                                      vector<float>(sb.positionData(), sb.positionData() + 2 * sb.size()), 2, tol);
+        error.tree = setDifference(segments2d(sim), segments2d(single), 4, tol);
+        errors.push_back(error);
+    }
+    return errors;
+}
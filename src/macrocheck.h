@@ -0,0 +1,33 @@
+#ifndef MACRO_CHECK_H
+#define MACRO_CHECK_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "leafsimulation.h"
+
+// How far one macro-step ended up from taking its increments one step at a
+// time, each part as a fraction: the margin as the largest distance of
+// either margin from the other over the leaf's width, the sources and the
+// tree's segments as the share of them left without a counterpart (nodes
+// stacked on one spot are counted one by one).
+struct MacroStepError{
+    uint64_t step = 0;      // where the macro-step started
+    uint64_t increments = 0;
+    float predicted = 0.0f; // the controller's area excess for it
+    float margin = 0.0f;
+    float sources = 0.0f;
+    float tree = 0.0f;
+    float worst() const {
+        return std::max(margin, std::max(sources, tree));
+    }
+};
+
+// Steps `sim` to step `until`. Every step that merges increments is also
+// replayed from a checkpoint taken before it, on a copy with macro-steps
+// and idle jumps off, and the two results are compared; returns one
+// error per macro-step. Slow, as it checkpoints before every step.
+std::vector<MacroStepError> checkMacroSteps(LeafSimulation& sim, uint64_t until);
+
+#endif
@@ -0,0 +1,41 @@
+#include "macrostep.h"
+
+#include <algorithm>
+
+using namespace std;
+
+int MacroStepController::choose(float marginGrowth, float smallChange, size_t liveSources, size_t pending,
+                                uint64_t untilSample){
+    lastExcess = 0.0f;
+    if (maxSteps <= 1 || untilSample <= 1 || liveSources > activityThreshold || pending > activityThreshold){
+        return 1;
+    }
+    // the margin scales about the petiole by (1 + g) per step, so the area
+    // scales by the square of the accumulated factor
+    double single = 1.0 + marginGrowth;
+    double factor = single;
+    double g = marginGrowth;
+    int k = 1;
+    while ((size_t)k < maxSteps && (uint64_t)k < untilSample){
+        g += smallChange;
+        double next = factor * (1.0 + g);
+        double excess = (next * next) / (single * single) - 1.0;
+        if (excess > areaExcessBound) break;
+        factor = next;
+        lastExcess = (float)excess;
+        k++;
+    }
+    if (k > 1){
+        macroSteps++;
+        mergedSteps += k - 1;
+        maxExcess = max(maxExcess, lastExcess);
+    }
+    return k;
+}
+
+void MacroStepController::reset(){
+    macroSteps = 0;
+    mergedSteps = 0;
+    lastExcess = 0.0f;
+    maxExcess = 0.0f;
+}
@@ -0,0 +1,57 @@
+#ifndef MACRO_STEP_H
+#define MACRO_STEP_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Chooses how many growth increments the next step may merge. While the
+// venation is quiet (few live sources and pending candidates) nothing but
+// the margin changes between steps, so k increments can be applied in one
+// pass, as long as the sampler isn't due before the last of them. k is also
+// kept to the largest value whose area "excess" (F_k / F_1)^2 - 1 stays
+// within `areaExcessBound`, F_k being the compounded scale factor of k
+// increments about the petiole: the extra leaf area the merged step adds
+// relative to one increment. That is a prediction from the growth schedule,
+// blind to growth fields, lobe rates and where the venation is;
+// checkMacroSteps() measures what merging actually changed.
+class MacroStepController{
+    private:
+        size_t maxSteps = 1;
+        float areaExcessBound = 0.01f;
+        size_t activityThreshold = 0;
+        unsigned long macroSteps = 0;  // steps that merged more than one increment
+        unsigned long mergedSteps = 0; // increments saved by merging
+        float lastExcess = 0.0f;
+        float maxExcess = 0.0f;
+    public:
+        void configure(size_t maxK, float bound, size_t threshold){
+            maxSteps = maxK;
+            areaExcessBound = bound;
+            activityThreshold = threshold;
+        }
+        // returns k >= 1 for a leaf growing by `marginGrowth` per step, with
+        // the rate rising by `smallChange` each step, and at most `untilSample`,
+        // the increments after which the sampler is due
+        int choose(float marginGrowth, float smallChange, size_t liveSources, size_t pending, uint64_t untilSample);
+        void reset();
+        void restore(unsigned long macroCount, unsigned long mergedCount, float maxEx){
+            macroSteps = macroCount;
+            mergedSteps = mergedCount;
+            maxExcess = maxEx;
+        }
+        unsigned long getMacroSteps(){
+            return macroSteps;
+        }
+        unsigned long getMergedSteps(){
+            return mergedSteps;
+        }
+        // predicted area excess of the last step and the largest so far
+        float getLastExcess(){
+            return lastExcess;
+        }
+        float getMaxExcess(){
+            return maxExcess;
+        }
+};
+
+#endif
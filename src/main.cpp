@@ -5,34 +5,14 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/rotate_vector.hpp>
 #include <glm/gtx/vector_angle.hpp>
-#include <ctime>
-
-#include "poisson_disk_sampling.h"
 
 #include "utils.h"
-#include "veinnode.h"
-
-#define MARGIN_RES 100
+#include "leafsimulation.h"
+#include "simrunner.h"
 
 using namespace std;
 
 int window_width = 1000, window_height = 1000;
-vector<float> leafMargin;
-vector<float> auxinSources;
-vector<float> nodesDisplay;
-float initGrowth = 1e-3f;
-float uniformGrowth = initGrowth; // simulate growth throughout leaf
-float marginGrowth = initGrowth; // simulate leaf margin growth
-float smallChange = 1e-6f; // change in growth per frame
-float srcSrcDist = 1.0f;
-float srcNodeDist = 1.0f;
-float nodeNodeDist = 1.0f;
-float killDist = 1.0f;
-float initUnitDist = 1.0f;
-float unitDist = initUnitDist;
-float petiole_x = 0.0f, petiole_y = 0.0f;
-float org_x = 0.0f, org_y = 0.0f; // transformed origin
-VeinNode* petiole;
 
 GLint vModel_uniform, vView_uniform, vProjection_uniform;
 glm::mat4 modelT, viewT, projectionT;//The model, view and projection transformations
@@ -41,106 +21,20 @@ void setupModelTransformation(unsigned int &);
 void setupViewTransformation(unsigned int &);
 void setupProjectionTransformation(unsigned int &);
 
-float euclidDistance(float x1, float y1, float x2, float y2){
-    return pow(pow(x1 - x2, 2) + pow(y1 - y2, 2), 0.5);
-}
-
-float getMarginDist(float phi){
-    // using Gielis Superformula
-    float m = 2.0, n1 = 1.0, n2 = 1.0, n3 = 1.0;
-    float a = 2.0, b = 1.0;
-    float raux = pow(abs(cos(m * phi / 4) / a), n2) + pow(abs(sin(m * phi / 4)) / b, n3);
-    float r = pow(abs(raux), - 1 / n1) * 20;
-    return r;
-}
-
-void drawLeafMargin(){
-    for (float phi = 0.0; phi < 2 * M_PI; phi += M_PI / MARGIN_RES){
-    float r = getMarginDist(phi);
-    leafMargin.push_back(r * cos(phi));
-    leafMargin.push_back(r * sin(phi));
-    leafMargin.push_back(0.0);
-    }
-    petiole_x = leafMargin[MARGIN_RES * 3] - smallChange;
-    petiole_y = leafMargin[MARGIN_RES * 3 + 1];
-    petiole = new VeinNode(petiole_x, petiole_y);
-}
-
-void growLeafMargin(){
-    for (int i = 0; i < leafMargin.size(); i += 3){
-        float slope = (leafMargin[i+1] - petiole_y) / (leafMargin[i] - petiole_x);
-        float theta = atan(slope);
-        float distance = euclidDistance(leafMargin[i], leafMargin[i+1], petiole_x, petiole_y);
-        leafMargin[i] += marginGrowth * distance * cos(theta);
-        leafMargin[i+1] += marginGrowth * distance * sin(theta);
-    }
-    float slope = (org_y - petiole_y) / (org_x - petiole_x);
-    float theta = atan(slope);
-    float distance = euclidDistance(org_x, org_y, petiole_x, petiole_y);
-    org_x += marginGrowth * distance * cos(theta);
-    org_y += marginGrowth * distance * sin(theta);
-    leafMargin[MARGIN_RES * 3] = petiole_x + smallChange; // petiole coordinates
-    leafMargin[MARGIN_RES * 3 + 1] = petiole_y;           // remain constant
-    uniformGrowth += smallChange;
-    unitDist = initUnitDist * initGrowth / uniformGrowth;
-    marginGrowth += smallChange;
-}
-
-void genAuxinSources(){
-    srand(time(0));
-    float x_min = leafMargin[MARGIN_RES * 3];
-    float x_max = leafMargin[0];
-    float y_max = leafMargin[MARGIN_RES * 3 / 2 + 1];
-    float y_min = -y_max;
-    array<float, 2> Xmin = {x_min, y_min};
-    array<float, 2> Xmax = {x_max, y_max};
-    vector<array<float, 2>> poissonRaw = thinks::PoissonDiskSampling(srcSrcDist * unitDist, Xmin, Xmax, rand() % 1000);
-    for (auto p : poissonRaw){
-        float angle = atan(p[1] / p[0]);
-        if ((p[0] < 0 && p[1] > 0) || (p[0] < 0 && p[1] < 0)){ // 2nd & 3rd quadrant
-            angle = M_PI + angle;
-        }
-        else if (p[0] > 0 && p[1] < 0){ // 4th quadrant
-            angle = 2 * M_PI + angle;
-        }
-        int idx = 3 * static_cast<int>(angle * MARGIN_RES / M_PI);
-        float p_dist = euclidDistance(org_x, org_y, p[0], p[1]);
-        float margin_dist = euclidDistance(org_x, org_y, leafMargin[idx], leafMargin[idx+1]);
-        float scale = margin_dist / getMarginDist(angle);
-        margin_dist = scale * getMarginDist(angle);
-        if (p_dist <= margin_dist){
-            VeinNode* nearestNode = findNearestNode(petiole, p[0], p[1]);
-            bool checkSrcDist = true;
-            for (int i = 0; i < auxinSources.size(); i += 3){
-                if (euclidDistance(p[0], p[1], auxinSources[i], auxinSources[i+1]) < srcSrcDist * unitDist){
-                    checkSrcDist = false;
-                }
-            }
-            if (euclidDistance(nearestNode, p[0], p[1]) > srcNodeDist * unitDist && checkSrcDist){
-                auxinSources.push_back(p[0]);
-                auxinSources.push_back(p[1]);
-                auxinSources.push_back(0.0);
-            }
-        }
-    }
-}
-
-void findNearestNodes(){
-    vector<float> newAuxinSrcs;
-    for (int i = 0; i < auxinSources.size(); i += 3){
-        VeinNode* tmp = findNearestNode(petiole, auxinSources[i], auxinSources[i+1]);
-        if (euclidDistance(tmp, auxinSources[i], auxinSources[i+1]) > killDist * unitDist){
-            newAuxinSrcs.push_back(auxinSources[i]);
-            newAuxinSrcs.push_back(auxinSources[i+1]);
-            newAuxinSrcs.push_back(0.0f);
-            tmp->addNewAuxinSrc(auxinSources[i], auxinSources[i+1]);
-        }
-    }
-    auxinSources = newAuxinSrcs;
-}
-
-int main(int, char *argv[])
+int main(int argc, char *argv[])
 {
+    SimulationParams params;
+    if (argc > 1){
+        params.seed = strtoull(argv[1], nullptr, 10);
+    }
+    LeafSimulation sim(params);
+    SimulationRunner runner(sim); // steps on its own thread, unbound by vsync
+    int candidateBudget = 0;
+    float candidateMillis = 0.0f;
+    int macroMaxSteps = 1;
+    bool paused = false;
+    int ffSteps = 1000, ffNodes = 0;
+    float ffArea = 0.0f;
     GLFWwindow *window = setupWindow(window_width, window_height);
     ImGuiIO &io = ImGui::GetIO(); // Create IO object
 
@@ -171,17 +65,86 @@ int main(int, char *argv[])
 
     bool display_srcs = false;
 
-    drawLeafMargin();
+    runner.start();
 
     // Display loop
     while (!glfwWindowShouldClose(window))
     {
-        glfwPollEvents();
+        if (runner.isFastForwarding()){
+            glfwWaitEventsTimeout(0.25); // a few frames per second is plenty
+        }
+        else {
+            glfwPollEvents();
+        }
 
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
+
+        const SimSnapshot& snap = runner.latest();
+
+        ImGui::Begin("Simulation");
+        ImGui::Text("Step: %llu (%.0f steps/s)", (unsigned long long)snap.step, snap.stepsPerSecond);
+        ImGui::Text("Vein nodes: %zu", snap.nodeCount);
+        ImGui::Text("Auxin sources: %zu", snap.sources.size() / 2);
+        ImGui::Text("Sampler runs: %lu, skipped: %lu", snap.samplerRuns, snap.samplerSkipped);
+        ImGui::Text("Pending candidates: %zu", snap.pendingCandidates);
+        ImGui::Text("Growth increments merged: %lu", snap.mergedIncrements);
+        ImGui::Text("Idle stages skipped: %lu", snap.skippedStages);
+        paused = runner.isPaused();
+        if (ImGui::Checkbox("Pause", &paused)){
+            runner.setPaused(paused);
+        }
+        ImGui::Separator();
+        ImGui::InputInt("FF steps", &ffSteps);
+        ImGui::InputInt("FF until nodes", &ffNodes);
+        ImGui::InputFloat("FF until area", &ffArea);
+        if (snap.fastForward){
+            ImGui::ProgressBar(snap.progress);
+            if (ImGui::Button("Cancel")){
+                runner.cancel();
+            }
+        }
+        else if (ImGui::Button("Fast-forward")){
+            RunTarget target;
+            target.steps = max(ffSteps, 0);
+            target.nodeCount = max(ffNodes, 0);
+            target.leafArea = max(ffArea, 0.0f);
+            runner.fastForward(target);
+        }
+        if (runner.isWritingCheckpoint()){
+            ImGui::Text("Writing checkpoint...");
+        }
+        else if (ImGui::Button("Save checkpoint")){
+            runner.requestCheckpoint("leaf.ckpt");
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Load checkpoint")){
+            runner.requestRestore("leaf.ckpt");
+        }
+        ImGui::Separator();
+        bool changed = false;
+        if (ImGui::SliderInt("Candidate budget", &candidateBudget, 0, 2000)){
+            params.candidateBudget = candidateBudget;
+            changed = true;
+        }
+        // stops admitting once the step has spent this long on it, so the
+        // leaf then depends on timing and no longer on the seed alone
+        if (ImGui::SliderFloat("Candidate time (ms)", &candidateMillis, 0.0f, 50.0f, "%.1f")){
+            params.candidateMillis = candidateMillis;
+            changed = true;
+        }
+        if (ImGui::SliderInt("Max macro-step", &macroMaxSteps, 1, 64)){
+            params.macroMaxSteps = macroMaxSteps;
+            changed = true;
+        }
+        changed |= ImGui::SliderFloat("Midrib spacing", &params.midribSpacing, 0.25f, 4.0f);
+        changed |= ImGui::SliderFloat("Margin spacing", &params.marginSpacing, 0.25f, 4.0f);
+        if (changed){
+            runner.updateParams(params);
+        }
+        ImGui::End();
         ImGui::Render();
 
         int display_w, display_h;
@@ -191,53 +154,49 @@ int main(int, char *argv[])
         glClearColor(clear_color.x, clear_color.y, clear_color.z, clear_color.w);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        genAuxinSources();
-
-        findNearestNodes();
-
-        nodesDisplay.clear();
-        flattenTree(petiole, nodesDisplay);
+        const vector<float>& leafMargin = snap.margin;
+        const vector<float>& auxinSources = snap.sources;
+        const vector<float>& nodesDisplay = snap.segments;
 
         glBindVertexArray(VAO_margin);
         glBindBuffer(GL_ARRAY_BUFFER, VBO_margin);
-        glBufferData(GL_ARRAY_BUFFER, leafMargin.size() * sizeof(float), &leafMargin[0], GL_DYNAMIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, leafMargin.size() * sizeof(float), leafMargin.data(), GL_DYNAMIC_DRAW);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
         glEnableVertexAttribArray(0);
 
         glBindVertexArray(VAO_auxinSrc);
         glBindBuffer(GL_ARRAY_BUFFER, VBO_auxinSrc);
-        glBufferData(GL_ARRAY_BUFFER, auxinSources.size() * sizeof(float), &auxinSources[0], GL_DYNAMIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+        glBufferData(GL_ARRAY_BUFFER, auxinSources.size() * sizeof(float), auxinSources.data(), GL_DYNAMIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0); // z defaults to 0
         glEnableVertexAttribArray(0);
 
         glBindVertexArray(VAO_node);
         glBindBuffer(GL_ARRAY_BUFFER, VBO_node);
-        glBufferData(GL_ARRAY_BUFFER, nodesDisplay.size() * sizeof(float), &nodesDisplay[0], GL_DYNAMIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, nodesDisplay.size() * sizeof(float), nodesDisplay.data(), GL_DYNAMIC_DRAW);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
         glEnableVertexAttribArray(0);
 
         glUseProgram(shaderProgram);
 
         glBindVertexArray(VAO_margin);
-        glDrawArrays(GL_LINE_LOOP, 0, leafMargin.size() / 3);
+        for (size_t k = 0; k + 1 < snap.marginRings.size(); k++){
+            glDrawArrays(GL_LINE_LOOP, snap.marginRings[k], snap.marginRings[k + 1] - snap.marginRings[k]);
+        }
 
         glBindVertexArray(VAO_auxinSrc);
-        glDrawArrays(GL_POINTS, 0, auxinSources.size() / 3);
+        glDrawArrays(GL_POINTS, 0, auxinSources.size() / 2);
 
         glBindVertexArray(VAO_node);
         glDrawArrays(GL_LINES, 0, nodesDisplay.size() / 3);
 
         glUseProgram(0);
-        
-        placeNewNodes(petiole, nodeNodeDist);
-
-        growLeafMargin();
 
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         glfwSwapBuffers(window);
     }
 
     // Cleanup
+    runner.stop();
     cleanup(window);
     return 0;
 }
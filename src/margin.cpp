@@ -0,0 +1,576 @@
+#include "margin.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "bspline.h"
+#include "simdkernels.h"
+
+using namespace std;
+
+void MarginLobe::point(float phi, float r, float& px, float& py) const {
+    float lx = r * cos(phi), ly = r * sin(phi);
+    float c = cos(rotation), sn = sin(rotation);
+    px = x + (lx * c - ly * sn);
+    py = y + (lx * sn + ly * c);
+}
+
+void LeafMargin::build(const vector<MarginLobe>& outline, size_t resolution){
+    clear();
+    lobes = outline;
+    size_t per = 2 * resolution;
+    vector<float> phi(per), r(per);
+    for (size_t k = 0; k < per; k++){
+        phi[k] = (float)(k * M_PI / resolution);
+    }
+    for (const MarginLobe& lobe : lobes){
+        rings.push_back(xs.size());
+        lobe.shape.evaluate(phi.data(), r.data(), per);
+        for (size_t k = 0; k < per; k++){
+            float px, py;
+            lobe.point(phi[k], r[k], px, py);
+            xs.push_back(px);
+            ys.push_back(py);
+            angles.push_back(phi[k]);
+            rates.push_back(lobe.rate);
+            scales.push_back(1.0f);
+        }
+    }
+    rings.push_back(xs.size());
+    petioleIndex = resolution;
+    updateBounds();
+    index.build(xs.data(), ys.data(), rings);
+}
+
+void LeafMargin::buildPolygon(const vector<float>& vx, const vector<float>& vy, size_t petiole){
+    clear();
+    size_t n = min(vx.size(), vy.size());
+    if (n < 3) return;
+    xs.assign(vx.begin(), vx.begin() + n);
+    ys.assign(vy.begin(), vy.begin() + n);
+    // arc length round the ring stands in for the lobe angle
+    vector<double> at(n + 1, 0.0);
+    for (size_t i = 0; i < n; i++){
+        size_t j = i + 1 == n ? 0 : i + 1;
+        at[i + 1] = at[i] + hypot((double)xs[j] - xs[i], (double)ys[j] - ys[i]);
+    }
+    angles.resize(n);
+    for (size_t i = 0; i < n; i++){
+        angles[i] = (float)(2 * M_PI * at[i] / at[n]);
+    }
+    rates.assign(n, 1.0f);
+    scales.assign(n, 1.0f);
+    rings = {0, n};
+    petioleIndex = min(petiole, n - 1);
+    onCurve = false;
+    updateBounds();
+    index.build(xs.data(), ys.data(), rings);
+}
+
+void LeafMargin::clear(){
+    lobes.clear();
+    rings.clear();
+    xs.clear();
+    ys.clear();
+    angles.clear();
+    rates.clear();
+    scales.clear();
+    petioleIndex = 0;
+    onCurve = true;
+    spline = false;
+    spanSamples = 0;
+    tx.clear();
+    ty.clear();
+    tableLength.clear();
+    ringLength.clear();
+    tableRings.clear();
+    index.clear();
+    x_min = x_max = y_min = y_max = 0.0f;
+}
+
+void LeafMargin::fitSpline(size_t controls, size_t samples){
+    if (spline || size() < 3) return;
+    size_t per = max<size_t>(controls, 4);
+    vector<float> qx(per), qy(per), px(per), py(per), na, nr, ns;
+    vector<size_t> nrings;
+    size_t newPetiole = 0;
+    tx.clear();
+    ty.clear();
+    for (size_t k = 0; k + 1 < rings.size(); k++){
+        size_t b = rings[k], e = rings[k + 1], count = e - b;
+        // arc length round the ring from the petiole, or from its first vertex
+        size_t first = petioleIndex >= b && petioleIndex < e ? petioleIndex : b;
+        vector<double> at(count + 1, 0.0);
+        for (size_t m = 0; m < count; m++){
+            size_t i = b + (first - b + m) % count, j = b + (first - b + m + 1) % count;
+            at[m + 1] = at[m] + hypot((double)xs[j] - xs[i], (double)ys[j] - ys[i]);
+        }
+        vector<float> qr(per), qs(per);
+        size_t seg = 0;
+        for (size_t m = 0; m < per; m++){
+            double s = at[count] * m / per;
+            while (seg + 1 < count && at[seg + 1] <= s) seg++;
+            size_t i = b + (first - b + seg) % count, j = b + (first - b + seg + 1) % count;
+            double len = at[seg + 1] - at[seg];
+            float t = len > 0.0 ? (float)((s - at[seg]) / len) : 0.0f;
+            qx[m] = xs[i] + t * (xs[j] - xs[i]);
+            qy[m] = ys[i] + t * (ys[j] - ys[i]);
+            qr[m] = rates[i] + t * (rates[j] - rates[i]);
+            qs[m] = scales[i] + t * (scales[j] - scales[i]);
+        }
+        if (first == petioleIndex){
+            // the petiole half way round, where build() puts it
+            rotate(qx.begin(), qx.begin() + per / 2, qx.end());
+            rotate(qy.begin(), qy.begin() + per / 2, qy.end());
+            rotate(qr.begin(), qr.begin() + per / 2, qr.end());
+            rotate(qs.begin(), qs.begin() + per / 2, qs.end());
+            newPetiole = na.size() + (per - per / 2);
+        }
+        splineInterpolate(qx.data(), qy.data(), per, px.data(), py.data());
+        nrings.push_back(na.size());
+        for (size_t m = 0; m < per; m++){
+            na.push_back((float)(2 * M_PI * m / per));
+        }
+        nr.insert(nr.end(), qr.begin(), qr.end());
+        ns.insert(ns.end(), qs.begin(), qs.end());
+        // the controls collect in tx, ty until every ring has been read
+        tx.insert(tx.end(), px.begin(), px.end());
+        ty.insert(ty.end(), py.begin(), py.end());
+    }
+    nrings.push_back(na.size());
+    xs.swap(tx);
+    ys.swap(ty);
+    angles.swap(na);
+    rates.swap(nr);
+    scales.swap(ns);
+    rings.swap(nrings);
+    petioleIndex = newPetiole;
+    onCurve = false;
+    spline = true;
+    spanSamples = max<size_t>(samples, 1);
+    tx.clear();
+    ty.clear();
+    sampleSpline();
+    updateBounds();
+    index.build(tx.data(), ty.data(), tableRings);
+}
+
+void LeafMargin::sampleSpline(){
+    size_t rc = rings.size() - 1;
+    size_t total = size() * spanSamples;
+    tx.resize(total);
+    ty.resize(total);
+    tableLength.resize(total);
+    ringLength.resize(rc);
+    tableRings.resize(rc + 1);
+    for (size_t k = 0; k < rc; k++){
+        size_t b = rings[k], n = rings[k + 1] - b;
+        size_t tb = b * spanSamples, count = n * spanSamples;
+        tableRings[k] = tb;
+        for (size_t m = 0; m < count; m++){
+            splinePoint(&xs[b], &ys[b], n, (float)m / spanSamples, tx[tb + m], ty[tb + m]);
+        }
+        float len = 0.0f;
+        for (size_t m = 0; m < count; m++){
+            tableLength[tb + m] = len;
+            size_t j = m + 1 == count ? tb : tb + m + 1;
+            len += hypot(tx[j] - tx[tb + m], ty[j] - ty[tb + m]);
+        }
+        ringLength[k] = len;
+    }
+    tableRings[rc] = total;
+}
+
+void LeafMargin::resampleAround(size_t i){
+    size_t k = 0;
+    while (rings[k + 1] <= i) k++;
+    size_t b = rings[k], n = rings[k + 1] - b;
+    size_t tb = tableRings[k], count = n * spanSamples;
+    // span j is shaped by controls j - 1 to j + 2, so control i moves spans
+    // i - 2 to i + 1
+    size_t first = count;
+    size_t spans = min<size_t>(n, 4);
+    for (size_t d = 0; d < spans; d++){
+        size_t span = (i - b + n - 2 + d) % n;
+        for (size_t m = span * spanSamples; m < (span + 1) * spanSamples; m++){
+            splinePoint(&xs[b], &ys[b], n, (float)m / spanSamples, tx[tb + m], ty[tb + m]);
+        }
+        first = min(first, span * spanSamples);
+    }
+    for (size_t d = 0; d < spans; d++){
+        size_t span = (i - b + n - 2 + d) % n;
+        for (size_t m = span * spanSamples; m < (span + 1) * spanSamples; m++){
+            index.updateVertex(tb + m);
+        }
+    }
+    // arc lengths from the chord into the first moved point on, summed in
+    // the same order as sampleSpline()
+    size_t from = first > 0 ? first - 1 : 0;
+    float len = tableLength[tb + from];
+    for (size_t m = from; m < count; m++){
+        tableLength[tb + m] = len;
+        size_t j = m + 1 == count ? tb : tb + m + 1;
+        len += hypot(tx[j] - tx[tb + m], ty[j] - ty[tb + m]);
+    }
+    ringLength[k] = len;
+}
+
+void LeafMargin::pointAtLength(size_t k, float s, float& x, float& y){
+    size_t b = rings[k], n = rings[k + 1] - b;
+    size_t tb = tableRings[k], te = tableRings[k + 1];
+    auto it = upper_bound(tableLength.begin() + tb, tableLength.begin() + te, s);
+    size_t m = (size_t)(it - tableLength.begin()) - 1;
+    float next = m + 1 == te ? ringLength[k] : tableLength[m + 1];
+    float len = next - tableLength[m];
+    float f = len > 0.0f ? (s - tableLength[m]) / len : 0.0f;
+    splinePoint(&xs[b], &ys[b], n, ((float)(m - tb) + f) / spanSamples, x, y);
+}
+
+size_t LeafMargin::refine(float maxEdge, float maxTurn, float minEdge, float cx, float cy){
+    if (spline){
+        // the table only ever gets finer, up to 64 points per span
+        if (maxEdge <= 0.0f) return 0;
+        float longest = 0.0f;
+        for (size_t k = 0; k + 1 < rings.size(); k++){
+            size_t b = tableRings[k], e = tableRings[k + 1];
+            for (size_t m = b; m < e; m++){
+                float next = m + 1 == e ? ringLength[k] : tableLength[m + 1];
+                longest = max(longest, next - tableLength[m]);
+            }
+        }
+        size_t samples = min<size_t>(64, (size_t)ceil(spanSamples * longest / maxEdge));
+        if (samples > spanSamples){
+            spanSamples = samples;
+            sampleSpline();
+            updateBounds();
+            index.build(tx.data(), ty.data(), tableRings);
+        }
+        return 0;
+    }
+    size_t added = 0;
+    vector<float> turn, nx, ny, na, nr, ns;
+    vector<size_t> nrings, fresh;
+    for (int pass = 0; pass < 16; pass++){
+        size_t n = size();
+        if (n < 3) break;
+        if (maxTurn > 0.0f){
+            turn.resize(n);
+            for (size_t k = 0; k + 1 < rings.size(); k++){
+                size_t b = rings[k], e = rings[k + 1];
+                for (size_t i = b; i < e; i++){
+                    size_t h = i == b ? e - 1 : i - 1, j = i + 1 == e ? b : i + 1;
+                    float ax = xs[i] - xs[h], ay = ys[i] - ys[h];
+                    float bx = xs[j] - xs[i], by = ys[j] - ys[i];
+                    turn[i] = abs(atan2(ax * by - ay * bx, ax * bx + ay * by));
+                }
+            }
+        }
+        nx.clear();
+        ny.clear();
+        na.clear();
+        nr.clear();
+        ns.clear();
+        nrings.clear();
+        fresh.clear();
+        size_t newPetiole = petioleIndex;
+        size_t inserted = 0;
+        for (size_t k = 0; k + 1 < rings.size(); k++){
+            size_t b = rings[k], e = rings[k + 1];
+            nrings.push_back(na.size());
+            for (size_t i = b; i < e; i++){
+                nx.push_back(xs[i]);
+                ny.push_back(ys[i]);
+                na.push_back(angles[i]);
+                nr.push_back(rates[i]);
+                ns.push_back(scales[i]);
+                if (i == petioleIndex){
+                    newPetiole = na.size() - 1;
+                }
+                size_t j = i + 1 == e ? b : i + 1;
+                float len = hypot(xs[j] - xs[i], ys[j] - ys[i]);
+                bool split = (maxEdge > 0.0f && len > maxEdge)
+                    || (maxTurn > 0.0f && len > minEdge && (turn[i] > maxTurn || turn[j] > maxTurn));
+                if (!split) continue;
+                float a0 = angles[i];
+                float a1 = j == b ? (float)(2 * M_PI) : angles[j];
+                float phi = 0.5f * (a0 + a1);
+                if (phi <= a0 || phi >= a1) continue; // no room left between them
+                float scale = 0.5f * (scales[i] + scales[j]);
+                fresh.push_back(na.size());
+                if (onCurve){
+                    const MarginLobe& lobe = lobes[k];
+                    float px, py;
+                    lobe.point(phi, lobe.shape(phi), px, py);
+                    nx.push_back(cx + scale * (px - cx));
+                    ny.push_back(cy + scale * (py - cy));
+                }
+                else {
+                    size_t h = i == b ? e - 1 : i - 1, l = j + 1 == e ? b : j + 1;
+                    nx.push_back((9.0f * (xs[i] + xs[j]) - xs[h] - xs[l]) / 16.0f);
+                    ny.push_back((9.0f * (ys[i] + ys[j]) - ys[h] - ys[l]) / 16.0f);
+                }
+                na.push_back(phi);
+                nr.push_back(0.5f * (rates[i] + rates[j]));
+                ns.push_back(scale);
+                inserted++;
+            }
+        }
+        if (inserted == 0) break;
+        nrings.push_back(na.size());
+        xs.swap(nx);
+        ys.swap(ny);
+        angles.swap(na);
+        rates.swap(nr);
+        scales.swap(ns);
+        rings.swap(nrings);
+        petioleIndex = newPetiole;
+        added += inserted;
+        index.insert(xs.data(), ys.data(), rings, fresh);
+    }
+    if (added > 0){
+        updateBounds();
+    }
+    return added;
+}
+
+void LeafMargin::grow(float growth, float cx, float cy){
+    scaleAboutPoint(xs.data(), ys.data(), scales.data(), rates.data(), size(), cx, cy, growth);
+    if (spline){
+        sampleSpline();
+    }
+    // vertices at the leaf's own rate keep their cells
+    index.scaleAbout(cx, cy, 1.0f + growth);
+    index.update();
+}
+
+void LeafMargin::scale(float factor, float cx, float cy){
+    size_t n = size();
+    scaleAbout(xs.data(), n, cx, cx, factor);
+    scaleAbout(ys.data(), n, cy, cy, factor);
+    for (float& s : scales){
+        s *= factor;
+    }
+    x_min = cx + factor * (x_min - cx);
+    x_max = cx + factor * (x_max - cx);
+    y_min = cy + factor * (y_min - cy);
+    y_max = cy + factor * (y_max - cy);
+    if (spline){
+        sampleSpline();
+    }
+    index.scaleAbout(cx, cy, factor);
+    index.update();
+}
+
+void LeafMargin::grow(const GrowthField& field, float growth, float cx, float cy){
+    array<float, 4> before = {x_min, y_min, x_max, y_max};
+    field.apply(xs.data(), ys.data(), 1, size(), cx, cy, growth, before);
+    onCurve = false;
+    if (spline){
+        sampleSpline();
+    }
+    updateBounds();
+    index.rescale(cx, cy, before, {x_min, y_min, x_max, y_max});
+}
+
+void LeafMargin::setVertex(size_t i, float x, float y){
+    xs[i] = x;
+    ys[i] = y;
+    if (spline){
+        resampleAround(i);
+    }
+    else {
+        index.updateVertex(i);
+    }
+}
+
+void LeafMargin::getPetiole(float& x, float& y){
+    if (!spline){
+        x = xs[petioleIndex];
+        y = ys[petioleIndex];
+        return;
+    }
+    size_t n = rings[1];
+    splinePoint(xs.data(), ys.data(), n, (float)petioleIndex, x, y);
+}
+
+void LeafMargin::setPetiole(float x, float y){
+    float px, py;
+    getPetiole(px, py);
+    if (spline){
+        // the curve passes through (c[i - 1] + 4 c[i] + c[i + 1]) / 6 at a knot
+        setVertex(petioleIndex, xs[petioleIndex] + 1.5f * (x - px), ys[petioleIndex] + 1.5f * (y - py));
+    }
+    else {
+        setVertex(petioleIndex, x, y);
+    }
+}
+
+void LeafMargin::setRates(const function<float(float)>& rateAt){
+    for (size_t i = 0; i < size(); i++){
+        rates[i] = rateAt(angles[i]);
+    }
+}
+
+void LeafMargin::fillCoords(vector<float>& coords, vector<int>& ringStarts, size_t perSpan){
+    if (!spline){
+        coords.resize(3 * size());
+        for (size_t i = 0; i < size(); i++){
+            coords[3*i] = xs[i];
+            coords[3*i+1] = ys[i];
+            coords[3*i+2] = 0.0f;
+        }
+        ringStarts.assign(rings.begin(), rings.end());
+        return;
+    }
+    perSpan = max<size_t>(perSpan, 1);
+    coords.clear();
+    ringStarts.clear();
+    for (size_t k = 0; k + 1 < rings.size(); k++){
+        ringStarts.push_back((int)(coords.size() / 3));
+        size_t count = (rings[k + 1] - rings[k]) * perSpan;
+        for (size_t m = 0; m < count; m++){
+            float x, y;
+            pointAtLength(k, ringLength[k] * m / count, x, y);
+            coords.insert(coords.end(), {x, y, 0.0f});
+        }
+    }
+    ringStarts.push_back((int)(coords.size() / 3));
+}
+
+float LeafMargin::signedDistance(float x, float y){
+    if (!spline || tx.empty()){
+        return index.signedDistance(x, y);
+    }
+    float nx, ny, t;
+    size_t k;
+    curveNearest(x, y, nx, ny, k, t);
+    float d = hypot(x - nx, y - ny);
+    // the table cuts inside the curve, so near it the index can be on the
+    // wrong side; ring k's own side comes from the curve's normal, the
+    // other rings' from the index
+    size_t b = rings[k], n = rings[k + 1] - b;
+    float dx, dy;
+    splineTangent(&xs[b], &ys[b], n, t, dx, dy);
+    bool in = (x - nx) * dy - (y - ny) * dx < 0.0f;
+    in = in || (index.ringsAt(x, y) & ~((uint64_t)1 << k)) != 0;
+    return in ? -d : d;
+}
+
+size_t LeafMargin::nearest(float x, float y, float& near_x, float& near_y){
+    size_t k;
+    float t;
+    return curveNearest(x, y, near_x, near_y, k, t);
+}
+
+size_t LeafMargin::curveNearest(float x, float y, float& near_x, float& near_y, size_t& k, float& t){
+    size_t e = index.nearest(x, y, near_x, near_y);
+    t = -1.0f;
+    if (!spline || e >= tx.size()){
+        return e;
+    }
+    // from the nearest table chord to the nearest point of the curve
+    k = upper_bound(tableRings.begin(), tableRings.end(), e) - tableRings.begin() - 1;
+    size_t tb = tableRings[k], te = tableRings[k + 1];
+    size_t j = e + 1 == te ? tb : e + 1;
+    float ex = tx[j] - tx[e], ey = ty[j] - ty[e];
+    float len2 = ex * ex + ey * ey;
+    float f = len2 > 0.0f ? ((near_x - tx[e]) * ex + (near_y - ty[e]) * ey) / len2 : 0.0f;
+    size_t b = rings[k], n = rings[k + 1] - b;
+    float s = ((float)(e - tb) + f) / spanSamples;
+    s = splineProject(&xs[b], &ys[b], n, s, x, y, 2.0f / spanSamples);
+    float cx, cy;
+    splinePoint(&xs[b], &ys[b], n, s, cx, cy);
+    // The chord cuts inside the curve, so its point is no yardstick; its
+    // ends are on the curve, and a projection that went astray settles no
+    // closer than them.
+    float dc = (cx - x) * (cx - x) + (cy - y) * (cy - y);
+    float de = (tx[e] - x) * (tx[e] - x) + (ty[e] - y) * (ty[e] - y);
+    float dj = (tx[j] - x) * (tx[j] - x) + (ty[j] - y) * (ty[j] - y);
+    if (dc > min(de, dj)){
+        size_t m = de <= dj ? e : j;
+        cx = tx[m];
+        cy = ty[m];
+        s = (float)(m - tb) / spanSamples;
+    }
+    near_x = cx;
+    near_y = cy;
+    t = s;
+    return b + min((size_t)s, n - 1);
+}
+
+float LeafMargin::area(){
+    if (rings.size() > 2 && !index.empty()){
+        return static_cast<float>(index.unionArea());
+    }
+    // shoelace formula, as polygonArea(); a spline's over its table
+    const vector<float>& vx = spline ? tx : xs;
+    const vector<float>& vy = spline ? ty : ys;
+    const vector<size_t>& starts = spline ? tableRings : rings;
+    double total = 0.0;
+    for (size_t k = 0; k + 1 < starts.size(); k++){
+        size_t b = starts[k], e = starts[k + 1];
+        if (e - b < 3) continue;
+        double sum = 0.0;
+        for (size_t i = b, j = e - 1; i < e; j = i++){
+            sum += (double)vx[j] * vy[i] - (double)vx[i] * vy[j];
+        }
+        total += fabs(sum) * 0.5;
+    }
+    return static_cast<float>(total);
+}
+
+void LeafMargin::updateBounds(){
+    if (angles.empty()) return;
+    const vector<float>& vx = spline ? tx : xs;
+    const vector<float>& vy = spline ? ty : ys;
+    auto x = minmax_element(vx.begin(), vx.end());
+    auto y = minmax_element(vy.begin(), vy.end());
+    x_min = *x.first;
+    x_max = *x.second;
+    y_min = *y.first;
+    y_max = *y.second;
+}
+
+bool LeafMargin::restore(const vector<MarginLobe>& outline, const vector<size_t>& ringStarts,
+                         const vector<float>& vx, const vector<float>& vy, const vector<float>& va,
+                         const vector<float>& vr, const vector<float>& vs, size_t petiole, bool curve,
+                         size_t splineSamples){
+    size_t n = va.size();
+    if (n < 3 || vx.size() != n || vy.size() != n || vr.size() != n || vs.size() != n || petiole >= n){
+        return false;
+    }
+    // a polygon from buildPolygon() has no lobes and one ring
+    size_t ringCount = outline.empty() ? 1 : outline.size();
+    if (splineSamples > 64 || (splineSamples > 0 && curve)){
+        return false;
+    }
+    if ((outline.empty() && curve) || ringCount > MARGIN_INDEX_MAX_RINGS || ringStarts.size() != ringCount + 1
+        || ringStarts.front() != 0 || ringStarts.back() != n){
+        return false;
+    }
+    for (size_t k = 0; k + 1 < ringStarts.size(); k++){
+        if (ringStarts[k + 1] < ringStarts[k] + 3) return false;
+    }
+    lobes = outline;
+    rings = ringStarts;
+    xs = vx;
+    ys = vy;
+    angles = va;
+    rates = vr;
+    scales = vs;
+    petioleIndex = petiole;
+    onCurve = curve;
+    spline = splineSamples > 0;
+    spanSamples = splineSamples;
+    if (spline){
+        sampleSpline();
+        updateBounds();
+        index.build(tx.data(), ty.data(), tableRings);
+        return true;
+    }
+    tx.clear();
+    ty.clear();
+    updateBounds();
+    index.build(xs.data(), ys.data(), rings);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,195 @@
+#ifndef MARGIN_H
+#define MARGIN_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "growthfield.h"
+#include "marginindex.h"
+#include "superformula.h"
+
+// One superformula lobe of the margin, centred on (x, y), turned by
+// `rotation` radians and growing at `rate` times the leaf.
+struct MarginLobe{
+    Superformula shape;
+    float x = 0.0f, y = 0.0f;
+    float rotation = 0.0f;
+    float rate = 1.0f;
+    // point at parameter phi, where the shape has radius r
+    void point(float phi, float r, float& px, float& py) const;
+};
+
+// Closed leaf margin, one ring of vertices per lobe, stored as parallel
+// arrays with the rings one after another. Inside is the union of the
+// rings. Every vertex remembers the angle its lobe was sampled at, in
+// increasing order round each ring. Growth scales each vertex away from
+// the petiole at its own rate, or moves it through a GrowthField, after
+// which the vertices no longer lie on the superformulae. Inside and
+// distance queries go through a MarginIndex kept up to date with every
+// change to the vertices.
+//
+// After fitSpline() the vertices are instead the control points of one
+// closed cubic B-spline per ring, a few dozen of them, and growth moves
+// just those. The curve is cached as a table of points a fixed number per
+// span, with their arc lengths; the index covers the table, and distances
+// are finished on the spline itself. Only fillCoords() tessellates densely,
+// at whatever resolution the caller draws at.
+class LeafMargin{
+    private:
+        std::vector<MarginLobe> lobes;
+        std::vector<size_t> rings; // first vertex of each lobe's ring, then size()
+        std::vector<float> xs, ys;
+        std::vector<float> angles; // increasing from 0 round each ring
+        std::vector<float> rates;  // growth rate relative to the leaf's, 1 = uniform
+        std::vector<float> scales; // growth applied to the vertex since build()
+        size_t petioleIndex = 0;   // vertex at angle pi of the first lobe
+        bool onCurve = true;       // vertices are the curves grown about the petiole
+        MarginIndex index;
+        bool spline = false;       // xs, ys are B-spline control points
+        size_t spanSamples = 0;    // table points per span
+        std::vector<float> tx, ty; // the table: points along each ring's curve
+        std::vector<float> tableLength; // arc length from the ring's first table point
+        std::vector<float> ringLength;  // round each ring
+        std::vector<size_t> tableRings;
+        float x_min = 0.0f, x_max = 0.0f, y_min = 0.0f, y_max = 0.0f;
+
+        // refills the table from the control points; the index needs a
+        // build() if the table changed size, else an update()
+        void sampleSpline();
+        // ... just the spans control point i shapes, after it moved
+        void resampleAround(size_t i);
+        // point of ring k at arc length s from its first table point
+        void pointAtLength(size_t k, float s, float& x, float& y);
+        // nearest() on a spline, also giving the ring and the curve
+        // parameter of the point
+        size_t curveNearest(float x, float y, float& near_x, float& near_y, size_t& k, float& t);
+    public:
+        // `resolution` vertices per half turn of each lobe; the first
+        // holds the petiole
+        void build(const std::vector<MarginLobe>& outline, size_t resolution);
+        // A single ring through the given counter-clockwise vertices, such as
+        // a digitised outline, with no lobes behind it: it starts off the
+        // curve, so refinement interpolates, and the angles are the arc
+        // length round the ring scaled to [0, 2 pi).
+        void buildPolygon(const std::vector<float>& vx, const std::vector<float>& vy, size_t petiole);
+        // Replaces every ring by a closed B-spline through `controls` points
+        // spaced evenly along it, the petiole's among them, cached at
+        // `samples` table points per span.
+        void fitSpline(size_t controls, size_t samples);
+        bool isSpline(){
+            return spline;
+        }
+        size_t getSpanSamples(){
+            return spanSamples;
+        }
+        // Subdivides edges longer than maxEdge, and edges longer than
+        // minEdge next to a vertex turning by more than maxTurn radians;
+        // 0 disables a criterion. New points lie on the curve grown about
+        // the petiole (cx, cy) by their neighbours' mean scale, or once a
+        // growth field has bent the margin off the curve, on the four-point
+        // interpolating subdivision of their neighbours. Returns the number
+        // of vertices added. A spline margin keeps its control points and
+        // only samples its table more finely, so no table chord is longer
+        // than maxEdge.
+        size_t refine(float maxEdge, float maxTurn, float minEdge, float cx, float cy);
+        // moves every vertex away from (cx, cy) by growth times its rate
+        void grow(float growth, float cx, float cy);
+        // scales the whole outline by `factor` about (cx, cy), keeping it
+        // on the (scaled) curve
+        void scale(float factor, float cx, float cy);
+        // moves every vertex by growth * T (p - c) for the field's T over
+        // the current bounds; angles are kept as the vertices' parameters
+        void grow(const GrowthField& field, float growth, float cx, float cy);
+        bool isOnCurve(){
+            return onCurve;
+        }
+        void clear();
+        size_t size(){
+            return angles.size();
+        }
+        float getX(size_t i){
+            return xs[i];
+        }
+        float getY(size_t i){
+            return ys[i];
+        }
+        void setVertex(size_t i, float x, float y);
+        // the margin point at the petiole, a vertex or a point on the spline
+        void getPetiole(float& x, float& y);
+        // ... moved to (x, y), for a spline by shifting its control point
+        void setPetiole(float x, float y);
+        float getAngle(size_t i){
+            return angles[i];
+        }
+        const std::vector<float>& getXs(){
+            return xs;
+        }
+        const std::vector<float>& getYs(){
+            return ys;
+        }
+        const std::vector<float>& getAngles(){
+            return angles;
+        }
+        const std::vector<float>& getRates(){
+            return rates;
+        }
+        const std::vector<float>& getScales(){
+            return scales;
+        }
+        void setRate(size_t i, float rate){
+            rates[i] = rate;
+        }
+        // rate of every vertex as a function of its angle
+        void setRates(const std::function<float(float)>& rateAt);
+        const std::vector<MarginLobe>& getLobes(){
+            return lobes;
+        }
+        const std::vector<size_t>& getRings(){
+            return rings;
+        }
+        size_t getPetioleIndex(){
+            return petioleIndex;
+        }
+        // x, y, z per vertex, for drawing and export, and the first vertex
+        // of each ring then the count; a spline is tessellated evenly by arc
+        // length at perSpan points per span
+        void fillCoords(std::vector<float>& coords, std::vector<int>& ringStarts, size_t perSpan);
+        // of the union of the rings, through the index when there are
+        // several; a spline's is its table's
+        float area();
+        bool inside(float x, float y){
+            return index.inside(x, y);
+        }
+        // distance to the margin, negative inside; a spline's is to the
+        // curve, so right next to it the sign can disagree with inside(),
+        // which tests the table
+        float signedDistance(float x, float y);
+        // nearest point on the margin; returns the edge (i, i + 1) it is
+        // on, or for a spline the span starting at control point i
+        size_t nearest(float x, float y, float& near_x, float& near_y);
+        const MarginIndex& getIndex(){
+            return index;
+        }
+        void updateBounds();
+        float getXMin(){
+            return x_min;
+        }
+        float getXMax(){
+            return x_max;
+        }
+        float getYMin(){
+            return y_min;
+        }
+        float getYMax(){
+            return y_max;
+        }
+        // for checkpoints, splineSamples > 0 for a spline margin; false if
+        // the arrays don't match up
+        bool restore(const std::vector<MarginLobe>& outline, const std::vector<size_t>& ringStarts,
+                     const std::vector<float>& vx, const std::vector<float>& vy, const std::vector<float>& va,
+                     const std::vector<float>& vr, const std::vector<float>& vs, size_t petiole, bool curve = true,
+                     size_t splineSamples = 0);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,383 @@
+#include "marginindex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+// edges are filed by their bounding box grown by this fraction of a cell,
+// so rounding never leaves one out of a cell it touches
+#define MARGIN_INDEX_PAD 1e-3f
+#define MARGIN_INDEX_MAX_CELLS 1024
+// how far the bounds' aspect may drift from the grid's before rescale()
+// rebuilds
+#define MARGIN_INDEX_MAX_DRIFT 1.5f
+
+int MarginIndex::colOf(float x) const {
+    float c = floor((x - ox) / cell);
+    return c < 0.0f ? 0 : (c >= (float)cols ? cols - 1 : (int)c);
+}
+
+int MarginIndex::rowOf(float y) const {
+    float r = floor((y - oy) / cell);
+    return r < 0.0f ? 0 : (r >= (float)rows ? rows - 1 : (int)r);
+}
+
+array<int, 4> MarginIndex::rangeOf(size_t e) const {
+    size_t f = next[e];
+    float pad = MARGIN_INDEX_PAD * cell;
+    return {colOf(min(xs[e], xs[f]) - pad), rowOf(min(ys[e], ys[f]) - pad),
+            colOf(max(xs[e], xs[f]) + pad), rowOf(max(ys[e], ys[f]) + pad)};
+}
+
+void MarginIndex::place(size_t e, const array<int, 4>& r){
+    for (int j = r[1]; j <= r[3]; j++){
+        for (int i = r[0]; i <= r[2]; i++){
+            cells[j * cols + i].push_back((uint32_t)e);
+        }
+    }
+}
+
+void MarginIndex::unplace(size_t e, const array<int, 4>& r){
+    for (int j = r[1]; j <= r[3]; j++){
+        for (int i = r[0]; i <= r[2]; i++){
+            vector<uint32_t>& c = cells[j * cols + i];
+            auto it = find(c.begin(), c.end(), (uint32_t)e);
+            if (it != c.end()){
+                *it = c.back();
+                c.pop_back();
+            }
+        }
+    }
+}
+
+void MarginIndex::build(const float* vx, const float* vy, size_t count){
+    build(vx, vy, vector<size_t>{0, count});
+}
+
+void MarginIndex::build(const float* vx, const float* vy, const vector<size_t>& rings){
+    clear();
+    size_t count = rings.empty() ? 0 : rings.back();
+    if (count < 3 || rings.size() > MARGIN_INDEX_MAX_RINGS + 1) return;
+    xs = vx;
+    ys = vy;
+    n = count;
+    link(rings);
+    auto x = minmax_element(xs, xs + n);
+    auto y = minmax_element(ys, ys + n);
+    float w = *x.second - *x.first, h = *y.second - *y.first;
+    float extent = max(max(w, h), 1e-6f);
+    // about one edge per cell
+    cell = max(sqrt(w * h / n), extent / MARGIN_INDEX_MAX_CELLS);
+    ox = *x.first - 0.01f * extent;
+    oy = *y.first - 0.01f * extent;
+    cols = min((int)ceil((w + 0.02f * extent) / cell), MARGIN_INDEX_MAX_CELLS);
+    rows = min((int)ceil((h + 0.02f * extent) / cell), MARGIN_INDEX_MAX_CELLS);
+    cols = max(cols, 1);
+    rows = max(rows, 1);
+    spanX = w / cell;
+    spanY = h / cell;
+    cells.assign((size_t)cols * rows, vector<uint32_t>());
+    ranges.resize(n);
+    for (size_t e = 0; e < n; e++){
+        ranges[e] = rangeOf(e);
+        place(e, ranges[e]);
+    }
+    crowded = max<size_t>(2 * maxOccupancy(), 8);
+}
+
+void MarginIndex::link(const vector<size_t>& rings){
+    starts = rings;
+    next.resize(n);
+    ringOf.resize(n);
+    for (size_t k = 0; k + 1 < rings.size(); k++){
+        for (size_t i = rings[k]; i < rings[k + 1]; i++){
+            next[i] = (uint32_t)(i + 1 == rings[k + 1] ? rings[k] : i + 1);
+            ringOf[i] = (uint8_t)k;
+        }
+    }
+}
+
+void MarginIndex::clear(){
+    cells.clear();
+    ranges.clear();
+    next.clear();
+    ringOf.clear();
+    starts.clear();
+    xs = ys = nullptr;
+    n = 0;
+    cols = rows = 0;
+}
+
+void MarginIndex::scaleAbout(float cx, float cy, float factor){
+    ox = cx + factor * (ox - cx);
+    oy = cy + factor * (oy - cy);
+    cell *= factor;
+}
+
+size_t MarginIndex::update(){
+    size_t moved = 0;
+    for (size_t e = 0; e < n; e++){
+        array<int, 4> r = rangeOf(e);
+        if (r != ranges[e]){
+            unplace(e, ranges[e]);
+            place(e, r);
+            ranges[e] = r;
+            moved++;
+        }
+    }
+    return moved;
+}
+
+void MarginIndex::updateVertex(size_t i){
+    if (i >= n) return;
+    size_t first = starts[ringOf[i]];
+    size_t prev = i == first ? starts[ringOf[i] + 1] - 1 : i - 1;
+    for (size_t e : {prev, i}){
+        array<int, 4> r = rangeOf(e);
+        if (r != ranges[e]){
+            unplace(e, ranges[e]);
+            place(e, r);
+            ranges[e] = r;
+        }
+    }
+}
+
+void MarginIndex::insert(const float* vx, const float* vy, const vector<size_t>& rings, const vector<size_t>& inserted){
+    size_t count = rings.empty() ? 0 : rings.back();
+    if (n < 3 || rings.size() != starts.size()){
+        build(vx, vy, rings);
+        return;
+    }
+    // every old vertex, and so its edge, moves up past the new vertices
+    // inserted before it
+    vector<uint32_t> moved(n);
+    vector<uint8_t> fresh(count, 0);
+    for (size_t v = 0, a = 0; v < count; v++){
+        if (a < inserted.size() && inserted[a] == v){
+            fresh[v] = 1;
+            a++;
+        }
+        else {
+            moved[v - a] = (uint32_t)v;
+        }
+    }
+    for (vector<uint32_t>& c : cells){
+        for (uint32_t& e : c){
+            e = moved[e];
+        }
+    }
+    vector<array<int, 4>> old(count);
+    for (size_t e = 0; e < n; e++){
+        old[moved[e]] = ranges[e];
+    }
+    ranges.swap(old);
+    xs = vx;
+    ys = vy;
+    n = count;
+    link(rings);
+    // a new vertex v splits the edge that ran from the vertex before it
+    for (size_t v : inserted){
+        size_t b = starts[ringOf[v]];
+        size_t prev = v == b ? starts[ringOf[v] + 1] - 1 : v - 1;
+        if (!fresh[prev]){
+            unplace(prev, ranges[prev]);
+            ranges[prev] = rangeOf(prev);
+            place(prev, ranges[prev]);
+        }
+        ranges[v] = rangeOf(v);
+        place(v, ranges[v]);
+    }
+    for (size_t v : inserted){
+        const array<int, 4>& r = ranges[v];
+        for (int j = r[1]; j <= r[3]; j++){
+            for (int i = r[0]; i <= r[2]; i++){
+                if (cells[j * cols + i].size() >= crowded){
+                    vector<size_t> copy = starts;
+                    build(xs, ys, copy);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+void MarginIndex::rescale(float cx, float cy, const array<float, 4>& before, const array<float, 4>& after){
+    float w0 = before[2] - before[0], h0 = before[3] - before[1];
+    float w1 = after[2] - after[0], h1 = after[3] - after[1];
+    if (n < 3 || w0 <= 0.0f || h0 <= 0.0f || w1 <= 0.0f || h1 <= 0.0f){
+        update();
+        return;
+    }
+    scaleAbout(cx, cy, sqrt((w1 / w0) * (h1 / h0)));
+    float drift = (w1 / cell / spanX) / (h1 / cell / spanY);
+    if (drift > MARGIN_INDEX_MAX_DRIFT || drift < 1.0f / MARGIN_INDEX_MAX_DRIFT){
+        vector<size_t> copy = starts;
+        build(xs, ys, copy);
+        return;
+    }
+    update();
+}
+
+size_t MarginIndex::maxOccupancy() const {
+    size_t most = 0;
+    for (const vector<uint32_t>& c : cells){
+        most = max(most, c.size());
+    }
+    return most;
+}
+
+bool MarginIndex::inside(float x, float y) const {
+    return ringsAt(x, y) != 0;
+}
+
+uint64_t MarginIndex::ringsAt(float x, float y) const {
+    if (n < 3) return 0;
+    // Count crossings of a ray along the row towards the nearer side of
+    // the grid, one parity bit per ring; an edge is counted only in the
+    // cell its crossing lies in, so edges listed in several cells count
+    // once.
+    int j = rowOf(y), c0 = colOf(x);
+    bool right = cols - 1 - c0 <= c0;
+    int step = right ? 1 : -1, last = right ? cols - 1 : 0;
+    uint64_t in = 0;
+    for (int c = c0;; c += step){
+        for (uint32_t e : cells[j * cols + c]){
+            size_t f = next[e];
+            float ay = ys[e], by = ys[f];
+            if ((ay > y) == (by > y)) continue;
+            float xc = xs[e] + (y - ay) * (xs[f] - xs[e]) / (by - ay);
+            if ((right ? xc > x : xc <= x) && colOf(xc) == c){
+                in ^= (uint64_t)1 << ringOf[e];
+            }
+        }
+        if (c == last) break;
+    }
+    return in;
+}
+
+double MarginIndex::unionArea() const {
+    // Green's theorem over the boundary of the union: the pieces of each
+    // ring's edges that lie outside every other ring, each ring taken
+    // counter-clockwise. A piece's side only changes where its edge
+    // crosses another ring, so only pieces next to a crossing need an
+    // inside query; the rest inherit the side of the piece before.
+    if (n < 3) return 0.0;
+    double total = 0.0;
+    vector<double> cuts;
+    for (size_t k = 0; k + 1 < starts.size(); k++){
+        size_t b = starts[k], end = starts[k + 1];
+        if (end - b < 3) continue;
+        double sum = 0.0;
+        for (size_t i = b, j = end - 1; i < end; j = i++){
+            sum += (double)xs[j] * ys[i] - (double)xs[i] * ys[j];
+        }
+        double sign = sum < 0.0 ? -1.0 : 1.0;
+        uint64_t others = ~((uint64_t)1 << k);
+        bool known = false, outside = true;
+        for (size_t e = b; e < end; e++){
+            size_t f = next[e];
+            double ax = xs[e], ay = ys[e], rx = xs[f] - ax, ry = ys[f] - ay;
+            cuts.assign({0.0, 1.0});
+            bool crossed = false;
+            const array<int, 4>& r = ranges[e];
+            for (int j = r[1]; j <= r[3]; j++){
+                for (int i = r[0]; i <= r[2]; i++){
+                    for (uint32_t g : cells[j * cols + i]){
+                        if (ringOf[g] == k) continue;
+                        size_t h = next[g];
+                        double cx = xs[g] - ax, cy = ys[g] - ay, sx = xs[h] - xs[g], sy = ys[h] - ys[g];
+                        double denom = rx * sy - ry * sx;
+                        if (denom == 0.0) continue;
+                        double t = (cx * sy - cy * sx) / denom, u = (cx * ry - cy * rx) / denom;
+                        if (t < 0.0 || t > 1.0 || u < 0.0 || u > 1.0) continue;
+                        // a crossing at a vertex cuts nothing but may still
+                        // change the side
+                        crossed = true;
+                        if (t > 0.0 && t < 1.0){
+                            cuts.push_back(t);
+                        }
+                    }
+                }
+            }
+            sort(cuts.begin(), cuts.end());
+            cuts.erase(unique(cuts.begin(), cuts.end()), cuts.end());
+            for (size_t m = 0; m + 1 < cuts.size(); m++){
+                double t0 = cuts[m], t1 = cuts[m + 1];
+                if (crossed || !known){
+                    double mt = 0.5 * (t0 + t1);
+                    outside = (ringsAt((float)(ax + mt * rx), (float)(ay + mt * ry)) & others) == 0;
+                    known = true;
+                }
+                if (outside){
+                    double x0 = ax + t0 * rx, y0 = ay + t0 * ry, x1 = ax + t1 * rx, y1 = ay + t1 * ry;
+                    total += sign * (x0 * y1 - x1 * y0);
+                }
+            }
+        }
+    }
+    return 0.5 * total;
+}
+
+size_t MarginIndex::nearest(float x, float y, float& near_x, float& near_y) const {
+    // Grow a square of cells around the query's own cell, which may lie
+    // off the grid, until no cell outside it can hold anything closer than
+    // the best so far. Only the part of the square on the grid is visited,
+    // where edges off the grid are filed too.
+    float best = numeric_limits<float>::max();
+    size_t bestEdge = 0;
+    near_x = x;
+    near_y = y;
+    if (n < 2) return 0;
+    float fx = min(max(floor((x - ox) / cell), -1e6f), 1e6f);
+    float fy = min(max(floor((y - oy) / cell), -1e6f), 1e6f);
+    int ci = (int)fx, cj = (int)fy;
+    int r = max(max(-ci, ci - (cols - 1)), max(-cj, cj - (rows - 1)));
+    r = max(r, 0);
+    int pi0 = 0, pi1 = -1, pj0 = 0, pj1 = -1; // visited so far
+    for (;; r++){
+        int i0 = max(ci - r, 0), i1 = min(ci + r, cols - 1);
+        int j0 = max(cj - r, 0), j1 = min(cj + r, rows - 1);
+        for (int j = j0; j <= j1; j++){
+            for (int i = i0; i <= i1; i++){
+                if (i >= pi0 && i <= pi1 && j >= pj0 && j <= pj1){
+                    i = pi1;
+                    continue;
+                }
+                for (uint32_t e : cells[j * cols + i]){
+                    size_t f = next[e];
+                    float ex = xs[f] - xs[e], ey = ys[f] - ys[e];
+                    float len = ex * ex + ey * ey;
+                    float t = len > 0.0f ? ((x - xs[e]) * ex + (y - ys[e]) * ey) / len : 0.0f;
+                    t = min(max(t, 0.0f), 1.0f);
+                    float px = xs[e] + t * ex, py = ys[e] + t * ey;
+                    float d = (px - x) * (px - x) + (py - y) * (py - y);
+                    if (d < best){
+                        best = d;
+                        bestEdge = e;
+                        near_x = px;
+                        near_y = py;
+                    }
+                }
+            }
+        }
+        if (i0 == 0 && j0 == 0 && i1 == cols - 1 && j1 == rows - 1) break;
+        pi0 = i0;
+        pi1 = i1;
+        pj0 = j0;
+        pj1 = j1;
+        float bx0 = ox + (ci - r) * cell, bx1 = ox + (ci + r + 1) * cell;
+        float by0 = oy + (cj - r) * cell, by1 = oy + (cj + r + 1) * cell;
+        float reach = min(min(x - bx0, bx1 - x), min(y - by0, by1 - y));
+        if (best <= reach * reach) break;
+    }
+    return bestEdge;
+}
+
+float MarginIndex::signedDistance(float x, float y) const {
+    float px, py;
+    nearest(x, y, px, py);
+    float d = hypot(px - x, py - y);
+    return inside(x, y) ? -d : d;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#ifndef MARGIN_INDEX_H
+#define MARGIN_INDEX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define MARGIN_INDEX_MAX_RINGS 64
+
+// Uniform grid over one or more closed rings, listing in every cell the
+// edges whose (slightly padded) bounding box overlaps it; edge i runs from
+// vertex i to the next vertex of its ring, wrapping. Rings may overlap and
+// the inside is their union. Queries only look at the cells around the
+// query point or along one row, so they don't depend on the shape being
+// star shaped about any point. Points and edges outside the grid are clamped
+// into its border cells, so the answers stay exact however far the
+// polygon has grown since build().
+class MarginIndex{
+    private:
+        int cols = 0, rows = 0;
+        float ox = 0.0f, oy = 0.0f; // grid corner
+        float cell = 1.0f;
+        std::vector<std::vector<uint32_t>> cells;
+        std::vector<std::array<int, 4>> ranges; // per edge: first col, first row, last col, last row
+        std::vector<uint32_t> next;  // per vertex, the next one round its ring
+        std::vector<uint8_t> ringOf; // per vertex
+        std::vector<size_t> starts;  // first vertex of each ring, then the count
+        const float* xs = nullptr;
+        const float* ys = nullptr;
+        size_t n = 0;
+        size_t crowded = 0;         // edges in one cell at which insert() rebuilds
+        float spanX = 0.0f, spanY = 0.0f; // vertex bounds at the last build(), in cells
+
+        int colOf(float x) const;
+        int rowOf(float y) const;
+        std::array<int, 4> rangeOf(size_t e) const;
+        void place(size_t e, const std::array<int, 4>& r);
+        void unplace(size_t e, const std::array<int, 4>& r);
+        // next and ringOf for ring starts `rings`
+        void link(const std::vector<size_t>& rings);
+    public:
+        // indexes the vertices at vx, vy, which must stay alive and in
+        // place until the next build(); ring k runs from rings[k] to
+        // rings[k + 1], at most MARGIN_INDEX_MAX_RINGS of them
+        void build(const float* vx, const float* vy, const std::vector<size_t>& rings);
+        // a single ring of `count` vertices
+        void build(const float* vx, const float* vy, size_t count);
+        void clear();
+        bool empty() const {
+            return n == 0;
+        }
+        // The vertices were scaled by `factor` about (cx, cy): scales the
+        // grid with them, so edges keep their cells.
+        void scaleAbout(float cx, float cy, float factor);
+        // re-files the edges that have left their cells after the vertices
+        // moved; returns how many moved
+        size_t update();
+        // ... or just the two edges at vertex i
+        void updateVertex(size_t i);
+        // The vertices now live at vx, vy with new ones inserted between
+        // them, `inserted` holding the new index of each in increasing
+        // order, and the rings start at `rings`. Files the new edges and
+        // re-files the ones they split, and rebuilds once that leaves a cell
+        // with twice the edges of the fullest cell at build().
+        void insert(const float* vx, const float* vy, const std::vector<size_t>& rings,
+                    const std::vector<size_t>& inserted);
+        // The vertices moved, not all by one scale, and their bounds went
+        // from `before` to `after` (x min, y min, x max, y max): scales the
+        // grid about (cx, cy) with the bounds' area and re-files the edges
+        // that left their cells. Rebuilds instead once either side has
+        // grown or shrunk by half again against the other since build().
+        void rescale(float cx, float cy, const std::array<float, 4>& before, const std::array<float, 4>& after);
+        // even-odd rule within each ring, union across rings
+        bool inside(float x, float y) const;
+        // bit k set if (x, y) is inside ring k
+        uint64_t ringsAt(float x, float y) const;
+        // area of the union of the rings, overlaps counted once
+        double unionArea() const;
+        // Distance to the nearest point of the margin, negative inside.
+        // Where rings overlap, the nearest point may be on a ring's edge
+        // that lies inside another one.
+        float signedDistance(float x, float y) const;
+        // nearest point of the margin and the edge it lies on
+        size_t nearest(float x, float y, float& near_x, float& near_y) const;
+        int getCols() const {
+            return cols;
+        }
+        int getRows() const {
+            return rows;
+        }
+        // most edges listed in one cell
+        size_t maxOccupancy() const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,372 @@
+#include "outline.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+#define OUTLINE_CURVE_STEPS 16
+
+static bool readFile(const char* path, string& text){
+    FILE* file = fopen(path, "rb");
+    if (file == NULL){
+        fprintf(stderr, "Error opening %s: ", path); perror("");
+        return false;
+    }
+    char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0){
+        text.append(buffer, n);
+    }
+    fclose(file);
+    return true;
+}
+
+static bool endsWith(const char* s, const char* suffix){
+    size_t a = strlen(s), b = strlen(suffix);
+    if (a < b) return false;
+    for (size_t i = 0; i < b; i++){
+        if (tolower((unsigned char)s[a - b + i]) != suffix[i]) return false;
+    }
+    return true;
+}
+
+// reads the next number of a path's data, skipping separators
+static bool pathNumber(const char*& p, float& v){
+    while (*p && (isspace((unsigned char)*p) || *p == ',')) p++;
+    char* end;
+    v = strtof(p, &end);
+    if (end == p) return false;
+    p = end;
+    return true;
+}
+
+static bool parseSvgPath(const char* d, vector<float>& xs, vector<float>& ys){
+    float x = 0.0f, y = 0.0f, sx = 0.0f, sy = 0.0f;
+    float cx = 0.0f, cy = 0.0f; // last control point, for S and T
+    char cmd = 0, prev = 0;
+    bool started = false;
+    const char* p = d;
+    auto point = [&](float px, float py){
+        xs.push_back(px);
+        ys.push_back(py);
+    };
+    while (*p){
+        while (*p && (isspace((unsigned char)*p) || *p == ',')) p++;
+        if (!*p) break;
+        if (isalpha((unsigned char)*p)){
+            cmd = *p++;
+        }
+        else if (!cmd){
+            return false;
+        }
+        bool rel = islower((unsigned char)cmd);
+        float ox = rel ? x : 0.0f, oy = rel ? y : 0.0f;
+        float a[6];
+        switch (toupper((unsigned char)cmd)){
+            case 'M':
+                if (started) return true; // only the first subpath
+                if (!pathNumber(p, a[0]) || !pathNumber(p, a[1])) return false;
+                x = sx = ox + a[0];
+                y = sy = oy + a[1];
+                point(x, y);
+                started = true;
+                cmd = rel ? 'l' : 'L'; // further pairs are lines
+                break;
+            case 'L':
+                if (!pathNumber(p, a[0]) || !pathNumber(p, a[1])) return false;
+                x = ox + a[0];
+                y = oy + a[1];
+                point(x, y);
+                break;
+            case 'H':
+                if (!pathNumber(p, a[0])) return false;
+                x = ox + a[0];
+                point(x, y);
+                break;
+            case 'V':
+                if (!pathNumber(p, a[0])) return false;
+                y = oy + a[0];
+                point(x, y);
+                break;
+            case 'C':
+            case 'S': {
+                bool smooth = toupper((unsigned char)cmd) == 'S';
+                int count = smooth ? 4 : 6;
+                for (int i = 0; i < count; i++){
+                    if (!pathNumber(p, a[i])) return false;
+                }
+                float x1, y1;
+                if (smooth){
+                    bool follows = prev == 'C' || prev == 'S';
+                    x1 = follows ? 2 * x - cx : x;
+                    y1 = follows ? 2 * y - cy : y;
+                    a[4] = a[2];
+                    a[5] = a[3];
+                    a[2] = a[0];
+                    a[3] = a[1];
+                }
+                else {
+                    x1 = ox + a[0];
+                    y1 = oy + a[1];
+                }
+                float x2 = ox + a[2], y2 = oy + a[3], x3 = ox + a[4], y3 = oy + a[5];
+                for (int k = 1; k <= OUTLINE_CURVE_STEPS; k++){
+                    float t = (float)k / OUTLINE_CURVE_STEPS, s = 1 - t;
+                    point(s * s * s * x + 3 * s * s * t * x1 + 3 * s * t * t * x2 + t * t * t * x3,
+                          s * s * s * y + 3 * s * s * t * y1 + 3 * s * t * t * y2 + t * t * t * y3);
+                }
+                cx = x2;
+                cy = y2;
+                x = x3;
+                y = y3;
+                break;
+            }
+            case 'Q':
+            case 'T': {
+                bool smooth = toupper((unsigned char)cmd) == 'T';
+                float x1, y1;
+                if (smooth){
+                    if (!pathNumber(p, a[2]) || !pathNumber(p, a[3])) return false;
+                    bool follows = prev == 'Q' || prev == 'T';
+                    x1 = follows ? 2 * x - cx : x;
+                    y1 = follows ? 2 * y - cy : y;
+                }
+                else {
+                    for (int i = 0; i < 4; i++){
+                        if (!pathNumber(p, a[i])) return false;
+                    }
+                    x1 = ox + a[0];
+                    y1 = oy + a[1];
+                }
+                float x2 = ox + a[2], y2 = oy + a[3];
+                for (int k = 1; k <= OUTLINE_CURVE_STEPS; k++){
+                    float t = (float)k / OUTLINE_CURVE_STEPS, s = 1 - t;
+                    point(s * s * x + 2 * s * t * x1 + t * t * x2, s * s * y + 2 * s * t * y1 + t * t * y2);
+                }
+                cx = x1;
+                cy = y1;
+                x = x2;
+                y = y2;
+                break;
+            }
+            case 'A':
+                // rx ry rotation large-arc sweep x y
+                for (int i = 0; i < 5; i++){
+                    if (!pathNumber(p, a[0])) return false;
+                }
+                if (!pathNumber(p, a[0]) || !pathNumber(p, a[1])) return false;
+                x = ox + a[0];
+                y = oy + a[1];
+                point(x, y);
+                break;
+            case 'Z':
+                x = sx;
+                y = sy;
+                return true;
+            default:
+                return false;
+        }
+        prev = (char)toupper((unsigned char)cmd);
+    }
+    return started;
+}
+
+static bool loadSvg(const char* path, vector<float>& xs, vector<float>& ys){
+    string text;
+    if (!readFile(path, text)) return false;
+    size_t tag = text.find("<path");
+    if (tag == string::npos){
+        fprintf(stderr, "Error: no <path> in %s\n", path);
+        return false;
+    }
+    // the d attribute of that tag: stop at the '>' closing it, skipping
+    // over quoted attribute values
+    size_t begin = string::npos, end = string::npos;
+    char quote = 0;
+    for (size_t i = tag + 5; i < text.size() && begin == string::npos; i++){
+        char c = text[i];
+        if (quote){
+            if (c == quote) quote = 0;
+            continue;
+        }
+        if (c == '"' || c == '\''){
+            quote = c;
+            continue;
+        }
+        if (c == '>') break;
+        if (c != 'd' || !isspace((unsigned char)text[i - 1])) continue;
+        size_t j = i + 1;
+        while (j < text.size() && isspace((unsigned char)text[j])) j++;
+        if (j == text.size() || text[j] != '=') continue;
+        j++;
+        while (j < text.size() && isspace((unsigned char)text[j])) j++;
+        if (j == text.size() || (text[j] != '"' && text[j] != '\'')){
+            fprintf(stderr, "Error: malformed path in %s\n", path);
+            return false;
+        }
+        begin = j + 1;
+        end = text.find(text[j], begin);
+        if (end == string::npos){
+            fprintf(stderr, "Error: malformed path in %s\n", path);
+            return false;
+        }
+    }
+    if (begin == string::npos){
+        fprintf(stderr, "Error: the first <path> in %s has no d attribute\n", path);
+        return false;
+    }
+    string d = text.substr(begin, end - begin);
+    if (!parseSvgPath(d.c_str(), xs, ys)){
+        fprintf(stderr, "Error: unsupported path data in %s\n", path);
+        return false;
+    }
+    for (float& y : ys){
+        y = -y;
+    }
+    return true;
+}
+
+static bool loadBinary(const char* path, vector<float>& xs, vector<float>& ys){
+    string data;
+    if (!readFile(path, data)) return false;
+    size_t count = data.size() / (2 * sizeof(float));
+    for (size_t i = 0; i < count; i++){
+        unsigned char b[8];
+        memcpy(b, data.data() + 8 * i, 8);
+        uint32_t wx = b[0] | b[1] << 8 | b[2] << 16 | (uint32_t)b[3] << 24;
+        uint32_t wy = b[4] | b[5] << 8 | b[6] << 16 | (uint32_t)b[7] << 24;
+        float fx, fy;
+        memcpy(&fx, &wx, 4);
+        memcpy(&fy, &wy, 4);
+        xs.push_back(fx);
+        ys.push_back(fy);
+    }
+    return true;
+}
+
+static bool loadText(const char* path, vector<float>& xs, vector<float>& ys){
+    string text;
+    if (!readFile(path, text)) return false;
+    size_t pos = 0;
+    while (pos < text.size()){
+        size_t end = text.find('\n', pos);
+        if (end == string::npos) end = text.size();
+        string line = text.substr(pos, end - pos);
+        pos = end + 1;
+        size_t hash = line.find('#');
+        if (hash != string::npos) line.resize(hash);
+        float x, y;
+        if (sscanf(line.c_str(), "%f%*[ ,;\t]%f", &x, &y) == 2){
+            xs.push_back(x);
+            ys.push_back(y);
+        }
+    }
+    return true;
+}
+
+bool loadOutline(const char* path, vector<float>& xs, vector<float>& ys){
+    xs.clear();
+    ys.clear();
+    bool ok;
+    if (endsWith(path, ".svg")){
+        ok = loadSvg(path, xs, ys);
+    }
+    else if (endsWith(path, ".bin")){
+        ok = loadBinary(path, xs, ys);
+    }
+    else {
+        ok = loadText(path, xs, ys);
+    }
+    if (!ok) return false;
+    // a closing repeat of the first point would make a zero-length edge
+    while (xs.size() > 1 && xs.back() == xs.front() && ys.back() == ys.front()){
+        xs.pop_back();
+        ys.pop_back();
+    }
+    if (xs.size() < 3){
+        fprintf(stderr, "Error: %s has fewer than 3 outline points\n", path);
+        return false;
+    }
+    double area = 0.0;
+    for (size_t i = 0, j = xs.size() - 1; i < xs.size(); j = i++){
+        area += (double)xs[j] * ys[i] - (double)xs[i] * ys[j];
+    }
+    if (area == 0.0){
+        fprintf(stderr, "Error: %s encloses no area\n", path);
+        return false;
+    }
+    if (area < 0.0){
+        reverse(xs.begin() + 1, xs.end());
+        reverse(ys.begin() + 1, ys.end());
+    }
+    return true;
+}
+
+void resampleOutline(vector<float>& xs, vector<float>& ys, size_t count){
+    size_t n = xs.size();
+    if (n < 2 || count < 3) return;
+    vector<double> at(n + 1, 0.0); // arc length at each vertex
+    for (size_t i = 0; i < n; i++){
+        size_t j = (i + 1) % n;
+        at[i + 1] = at[i] + hypot((double)xs[j] - xs[i], (double)ys[j] - ys[i]);
+    }
+    double total = at[n];
+    vector<float> rx(count), ry(count);
+    size_t seg = 0;
+    for (size_t k = 0; k < count; k++){
+        double s = total * k / count;
+        while (seg + 1 < n && at[seg + 1] <= s) seg++;
+        size_t j = (seg + 1) % n;
+        double len = at[seg + 1] - at[seg];
+        double t = len > 0.0 ? (s - at[seg]) / len : 0.0;
+        rx[k] = (float)(xs[seg] + t * (xs[j] - xs[seg]));
+        ry[k] = (float)(ys[seg] + t * (ys[j] - ys[seg]));
+    }
+    xs.swap(rx);
+    ys.swap(ry);
+}
+
+size_t nearestVertex(const vector<float>& xs, const vector<float>& ys, float x, float y){
+    size_t best = 0;
+    float bestDist = INFINITY;
+    for (size_t i = 0; i < xs.size(); i++){
+        float d = (xs[i] - x) * (xs[i] - x) + (ys[i] - y) * (ys[i] - y);
+        if (d < bestDist){
+            best = i;
+            bestDist = d;
+        }
+    }
+    return best;
+}
+
+void placeOutline(vector<float>& xs, vector<float>& ys, size_t petiole, float length){
+    size_t n = xs.size();
+    if (n < 3 || petiole >= n) return;
+    float px = xs[petiole], py = ys[petiole];
+    double mx = 0.0, my = 0.0;
+    for (size_t i = 0; i < n; i++){
+        mx += xs[i] - px;
+        my += ys[i] - py;
+    }
+    double turn = -atan2(my, mx);
+    float c = (float)cos(turn), s = (float)sin(turn);
+    for (size_t i = 0; i < n; i++){
+        float dx = xs[i] - px, dy = ys[i] - py;
+        xs[i] = dx * c - dy * s;
+        ys[i] = dx * s + dy * c;
+    }
+    auto range = minmax_element(xs.begin(), xs.end());
+    float extent = *range.second - *range.first;
+    float scale = extent > 0.0f ? length / extent : 1.0f;
+    for (size_t i = 0; i < n; i++){
+        xs[i] = xs[i] * scale - length / 3;
+        ys[i] *= scale;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef OUTLINE_H
+#define OUTLINE_H
+
+#include <cstddef>
+#include <vector>
+
+// Leaf outlines digitised from specimens. Supported files:
+//   .svg         the first subpath of the first <path>; M, L, H, V, C, S, Q,
+//                T and Z in either case, curves flattened, arcs taken as
+//                lines and transforms ignored; y is flipped to point up
+//   .bin         little-endian float32 x, y pairs
+//   anything else  text, one "x,y" or "x y" pair per line; '#' starts a
+//                comment and lines that don't parse are skipped
+// The outline comes back as an open list of vertices (the last one is not
+// a repeat of the first) running counter-clockwise.
+bool loadOutline(const char* path, std::vector<float>& xs, std::vector<float>& ys);
+// `count` vertices evenly spaced along the closed outline, starting at
+// the first
+void resampleOutline(std::vector<float>& xs, std::vector<float>& ys, size_t count);
+// vertex closest to (x, y)
+size_t nearestVertex(const std::vector<float>& xs, const std::vector<float>& ys, float x, float y);
+// Moves the outline so the petiole vertex sits where the built-in leaf has
+// its petiole, at (-length / 3, 0), pointing the leaf along +x: rotated
+// so the centroid lies on +x from the petiole, then scaled to `length`
+// along x.
+void placeOutline(std::vector<float>& xs, std::vector<float>& ys, size_t petiole, float length);
+
+#endif
\ No newline at end of file
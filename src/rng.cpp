@@ -0,0 +1,33 @@
+#include "rng.h"
+
+using namespace std;
+
+static const uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ULL;
+
+uint64_t splitMix64(uint64_t x){
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+CounterRng::CounterRng(uint64_t seed, uint64_t step, uint64_t tile){
+    // chain the coordinates through the mixer so that neighbouring
+    // (step, tile) pairs end up with unrelated keys
+    key = splitMix64(seed + GOLDEN_GAMMA);
+    key = splitMix64(key ^ (step + GOLDEN_GAMMA));
+    key = splitMix64(key ^ (tile + GOLDEN_GAMMA));
+}
+
+uint64_t CounterRng::next(){
+    counter++;
+    return splitMix64(key + counter * GOLDEN_GAMMA);
+}
+
+float CounterRng::nextFloat(){
+    // top 24 bits fill the float mantissa exactly
+    return static_cast<float>(next() >> 40) * (1.0f / 16777216.0f);
+}
+
+float CounterRng::nextRange(float lo, float hi){
+    return lo + (hi - lo) * nextFloat();
+}
@@ -0,0 +1,31 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// Counter-based random stream (SplitMix64 finaliser over a keyed counter).
+// Every draw is a pure function of (seed, step, tile, counter), so a stream
+// gives the same numbers no matter which thread consumes it or when.
+class CounterRng{
+    private:
+        uint64_t key;
+        uint64_t counter = 0;
+    public:
+        CounterRng(uint64_t seed, uint64_t step, uint64_t tile);
+        uint64_t next();
+        uint32_t nextU32(){
+            return static_cast<uint32_t>(next() >> 32);
+        }
+        float nextFloat();                  // uniform in [0, 1)
+        float nextRange(float lo, float hi); // uniform in [lo, hi)
+        uint64_t getCounter(){
+            return counter;
+        }
+        void skip(uint64_t n){
+            counter += n;
+        }
+};
+
+uint64_t splitMix64(uint64_t x);
+
+#endif
@@ -0,0 +1,42 @@
+#include "schedule.h"
+
+#include <cmath>
+
+using namespace std;
+
+bool SourceSchedule::wouldRun(float leafArea, size_t liveSources){
+    bool grown = leafArea >= lastArea * (1.0f + areaFraction);
+    bool starved = liveSources < minLiveSources && admitted > 0;
+    return !hasRun || grown || starved;
+}
+
+bool SourceSchedule::shouldRun(float leafArea, size_t liveSources){
+    if (wouldRun(leafArea, liveSources)){
+        hasRun = true;
+        lastArea = leafArea;
+        runs++;
+        admitted = 0;
+        return true;
+    }
+    skipped++;
+    return false;
+}
+
+void SourceSchedule::reset(){
+    lastArea = 0.0f;
+    hasRun = false;
+    runs = 0;
+    skipped = 0;
+    admitted = 0;
+}
+
+float polygonArea(const vector<float>& coords, int stride){
+    size_t n = coords.size() / stride;
+    if (n < 3) return 0.0f;
+    double sum = 0.0;
+    for (size_t i = 0, j = n - 1; i < n; j = i++){
+        sum += (double)coords[j * stride] * coords[i * stride + 1]
+             - (double)coords[i * stride] * coords[j * stride + 1];
+    }
+    return static_cast<float>(fabs(sum) * 0.5);
+}
@@ -0,0 +1,82 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <cstddef>
+#include <vector>
+
+// Decides when auxin generation is worth running. The sampler runs when
+// the leaf area has grown by areaFraction since the last run, or when the
+// number of live sources has dropped below minLiveSources and the last run
+// admitted at least one source; every other step is skipped and counted.
+// A run that admitted nothing won't do better until the leaf has grown, so
+// an empty leaf only resamples on growth.
+class SourceSchedule{
+    private:
+        float areaFraction;
+        size_t minLiveSources;
+        float lastArea = 0.0f;
+        bool hasRun = false;
+        unsigned long runs = 0;
+        unsigned long skipped = 0;
+        unsigned long admitted = 0; // sources admitted since the last run
+    public:
+        explicit SourceSchedule(float fraction = 0.01f, size_t minLive = 8):
+            areaFraction(fraction), minLiveSources(minLive){}
+        bool shouldRun(float leafArea, size_t liveSources);
+        // same decision as shouldRun() without recording it
+        bool wouldRun(float leafArea, size_t liveSources);
+        // leaf area at which the growth trigger fires next
+        float getNextRunArea(){
+            return lastArea * (1.0f + areaFraction);
+        }
+        // records `n` steps skipped without asking
+        void skip(unsigned long n){
+            skipped += n;
+        }
+        void reset();
+        // a source from the candidates was admitted
+        void countAdmitted(){
+            admitted++;
+        }
+        void restore(float area, bool ran, unsigned long runCount, unsigned long skipCount,
+                     unsigned long admittedCount){
+            lastArea = area;
+            hasRun = ran;
+            runs = runCount;
+            skipped = skipCount;
+            admitted = admittedCount;
+        }
+        float getLastArea(){
+            return lastArea;
+        }
+        bool getHasRun(){
+            return hasRun;
+        }
+        void setAreaFraction(float fraction){
+            areaFraction = fraction;
+        }
+        void setMinLiveSources(size_t minLive){
+            minLiveSources = minLive;
+        }
+        float getAreaFraction(){
+            return areaFraction;
+        }
+        size_t getMinLiveSources(){
+            return minLiveSources;
+        }
+        unsigned long getRuns(){
+            return runs;
+        }
+        unsigned long getSkipped(){
+            return skipped;
+        }
+        unsigned long getAdmitted(){
+            return admitted;
+        }
+};
+
+// shoelace area of a closed polygon stored as consecutive coordinates,
+// `stride` floats per vertex with x and y first
+float polygonArea(const std::vector<float>& coords, int stride);
+
+#endif
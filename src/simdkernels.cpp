@@ -0,0 +1,145 @@
+#include "simdkernels.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void scaleAboutPoint(float* xs, float* ys, float* scales, const float* rates, size_t n,
+                     float cx, float cy, float growth){
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128 vcx = _mm_set1_ps(cx), vcy = _mm_set1_ps(cy);
+    __m128 vg = _mm_set1_ps(growth), one = _mm_set1_ps(1.0f);
+    for (; i + 4 <= n; i += 4){
+        __m128 f = _mm_add_ps(one, _mm_mul_ps(vg, _mm_loadu_ps(rates + i)));
+        __m128 x = _mm_sub_ps(_mm_loadu_ps(xs + i), vcx);
+        __m128 y = _mm_sub_ps(_mm_loadu_ps(ys + i), vcy);
+        _mm_storeu_ps(xs + i, _mm_add_ps(vcx, _mm_mul_ps(f, x)));
+        _mm_storeu_ps(ys + i, _mm_add_ps(vcy, _mm_mul_ps(f, y)));
+        _mm_storeu_ps(scales + i, _mm_mul_ps(_mm_loadu_ps(scales + i), f));
+    }
+#endif
+    for (; i < n; i++){
+        float f = 1.0f + growth * rates[i];
+        xs[i] = cx + f * (xs[i] - cx);
+        ys[i] = cy + f * (ys[i] - cy);
+        scales[i] *= f;
+    }
+}
+
+void scaleAbout(float* v, size_t n, float c0, float c1, float factor){
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128 vc = _mm_set_ps(c1, c0, c1, c0), vf = _mm_set1_ps(factor);
+    for (; i + 4 <= n; i += 4){
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(v + i), vc);
+        _mm_storeu_ps(v + i, _mm_add_ps(vc, _mm_mul_ps(vf, d)));
+    }
+#endif
+    for (; i < n; i++){
+        float c = i % 2 ? c1 : c0;
+        v[i] = c + factor * (v[i] - c);
+    }
+}
+
+void growthFieldPass(float* xs, float* ys, size_t stride, size_t n, const float* t, int nx, int ny,
+                     float ox, float oy, float sx, float sy, float cx, float cy, float growth){
+    float maxX = (float)(nx - 1), maxY = (float)(ny - 1);
+    float lastX = (float)(nx - 2), lastY = (float)(ny - 2);
+    size_t row = 4 * (size_t)nx;
+    size_t k = 0;
+#if defined(__SSE2__)
+    __m128 vox = _mm_set1_ps(ox), voy = _mm_set1_ps(oy), vsx = _mm_set1_ps(sx), vsy = _mm_set1_ps(sy);
+    __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    __m128 vmaxX = _mm_set1_ps(maxX), vmaxY = _mm_set1_ps(maxY);
+    __m128 vlastX = _mm_set1_ps(lastX), vlastY = _mm_set1_ps(lastY);
+    __m128 vnx = _mm_set1_ps((float)nx), vcx = _mm_set1_ps(cx), vcy = _mm_set1_ps(cy), g = _mm_set1_ps(growth);
+    // x, y pairs side by side, as the auxin store keeps them
+    bool interleaved = stride == 2 && ys == xs + 1;
+    const size_t offset[4] = {0, 4, row, row + 4};
+    for (; k + 4 <= n; k += 4){
+        float* x0 = xs + k * stride;
+        float* y0 = ys + k * stride;
+        __m128 px, py;
+        if (interleaved){
+            __m128 lo = _mm_loadu_ps(x0), hi = _mm_loadu_ps(x0 + 4);
+            px = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+            py = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+        }
+        else{
+            px = _mm_setr_ps(x0[0], x0[stride], x0[2 * stride], x0[3 * stride]);
+            py = _mm_setr_ps(y0[0], y0[stride], y0[2 * stride], y0[3 * stride]);
+        }
+        __m128 fx = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(px, vox), vsx), zero), vmaxX);
+        __m128 fy = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(py, voy), vsy), zero), vmaxY);
+        // fx, fy >= 0, so truncation is the floor
+        __m128 ix = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(fx)), vlastX);
+        __m128 iy = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(fy)), vlastY);
+        __m128 tx = _mm_sub_ps(fx, ix), ty = _mm_sub_ps(fy, iy);
+        __m128 ux = _mm_sub_ps(one, tx), uy = _mm_sub_ps(one, ty);
+        __m128 w[4] = {_mm_mul_ps(ux, uy), _mm_mul_ps(tx, uy), _mm_mul_ps(ux, ty), _mm_mul_ps(tx, ty)};
+        alignas(16) int cell[4];
+        _mm_store_si128((__m128i*)cell, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(iy, vnx), ix)));
+        const float* c[4];
+        for (int lane = 0; lane < 4; lane++){
+            c[lane] = t + 4 * cell[lane];
+        }
+        // each corner's tensors for the four points, transposed into one
+        // register per component
+        __m128 b[4];
+        for (int corner = 0; corner < 4; corner++){
+            __m128 r0 = _mm_loadu_ps(c[0] + offset[corner]), r1 = _mm_loadu_ps(c[1] + offset[corner]);
+            __m128 r2 = _mm_loadu_ps(c[2] + offset[corner]), r3 = _mm_loadu_ps(c[3] + offset[corner]);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            __m128 wc = w[corner];
+            if (corner == 0){
+                b[0] = _mm_mul_ps(wc, r0);
+                b[1] = _mm_mul_ps(wc, r1);
+                b[2] = _mm_mul_ps(wc, r2);
+                b[3] = _mm_mul_ps(wc, r3);
+            }
+            else{
+                b[0] = _mm_add_ps(b[0], _mm_mul_ps(wc, r0));
+                b[1] = _mm_add_ps(b[1], _mm_mul_ps(wc, r1));
+                b[2] = _mm_add_ps(b[2], _mm_mul_ps(wc, r2));
+                b[3] = _mm_add_ps(b[3], _mm_mul_ps(wc, r3));
+            }
+        }
+        __m128 dx = _mm_sub_ps(px, vcx), dy = _mm_sub_ps(py, vcy);
+        __m128 nx4 = _mm_add_ps(px, _mm_mul_ps(g, _mm_add_ps(_mm_mul_ps(b[0], dx), _mm_mul_ps(b[1], dy))));
+        __m128 ny4 = _mm_add_ps(py, _mm_mul_ps(g, _mm_add_ps(_mm_mul_ps(b[2], dx), _mm_mul_ps(b[3], dy))));
+        if (interleaved){
+            _mm_storeu_ps(x0, _mm_unpacklo_ps(nx4, ny4));
+            _mm_storeu_ps(x0 + 4, _mm_unpackhi_ps(nx4, ny4));
+        }
+        else{
+            alignas(16) float rx[4], ry[4];
+            _mm_store_ps(rx, nx4);
+            _mm_store_ps(ry, ny4);
+            for (int lane = 0; lane < 4; lane++){
+                x0[lane * stride] = rx[lane];
+                y0[lane * stride] = ry[lane];
+            }
+        }
+    }
+#endif
+    for (; k < n; k++){
+        float px = xs[k * stride], py = ys[k * stride];
+        float fx = std::min(std::max((px - ox) * sx, 0.0f), maxX);
+        float fy = std::min(std::max((py - oy) * sy, 0.0f), maxY);
+        float ix = std::min((float)(int)fx, lastX), iy = std::min((float)(int)fy, lastY);
+        float tx = fx - ix, ty = fy - iy;
+        float w00 = (1 - tx) * (1 - ty), w10 = tx * (1 - ty);
+        float w01 = (1 - tx) * ty, w11 = tx * ty;
+        const float* c = t + 4 * (size_t)(iy * nx + ix);
+        float b[4];
+        for (int m = 0; m < 4; m++){
+            b[m] = w00 * c[m] + w10 * c[4 + m] + w01 * c[row + m] + w11 * c[row + 4 + m];
+        }
+        float dx = px - cx, dy = py - cy;
+        xs[k * stride] = px + growth * (b[0] * dx + b[1] * dy);
+        ys[k * stride] = py + growth * (b[2] * dx + b[3] * dy);
+    }
+}
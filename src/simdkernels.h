@@ -0,0 +1,28 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <cstddef>
+
+// Batched arithmetic over structure-of-arrays data. Each kernel has an SSE
+// path (four lanes) and a scalar tail/fallback doing the same operations
+// in the same order, so results match bit for bit whichever path runs.
+
+// For every i: f = 1 + growth * rates[i]; (xs[i], ys[i]) moves to
+// (cx, cy) + f * ((xs[i], ys[i]) - (cx, cy)) and scales[i] *= f.
+void scaleAboutPoint(float* xs, float* ys, float* scales, const float* rates, size_t n,
+                     float cx, float cy, float growth);
+
+// Over n floats: v[2k] = c0 + factor * (v[2k] - c0), and v[2k+1] the same
+// about c1. Interleaved x, y pairs pass the centre's x and y, a single
+// coordinate array the same value twice.
+void scaleAbout(float* v, size_t n, float c0, float c1, float factor);
+
+// Over n points at xs[k * stride], ys[k * stride]: the tensor is sampled
+// bilinearly from an nx x ny grid of nodes stored row by row as xx, xy,
+// yx, yy, at grid coordinates clamp((p - o) * s), and p moves by
+// growth * T (p - c). Four points at a time, each corner's four tensors
+// loaded whole and transposed to one register per component.
+void growthFieldPass(float* xs, float* ys, size_t stride, size_t n, const float* t, int nx, int ny,
+                     float ox, float oy, float sx, float sy, float cx, float cy, float growth);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "simrunner.h"
+
+#include <chrono>
+
+using namespace std;
+
+void SimulationRunner::start(){
+    if (worker.joinable()) return;
+    stopFlag = false;
+    publish(0.0);
+    worker = thread(&SimulationRunner::run, this);
+}
+
+void SimulationRunner::stop(){
+    stopFlag = true;
+    if (worker.joinable()){
+        worker.join();
+    }
+}
+
+void SimulationRunner::updateParams(const SimulationParams& p){
+    lock_guard<mutex> lock(paramsMutex);
+    pendingParams = p;
+    paramsDirty = true;
+}
+
+void SimulationRunner::fastForward(const RunTarget& target){
+    lock_guard<mutex> lock(paramsMutex);
+    pendingTarget = target;
+    targetDirty = true;
+    cancelFastForward = false;
+    fastForwarding = true;
+    pausedFlag = false;
+}
+
+void SimulationRunner::requestCheckpoint(const string& path){
+    lock_guard<mutex> lock(paramsMutex);
+    checkpointPath = path;
+}
+
+void SimulationRunner::requestRestore(const string& path){
+    lock_guard<mutex> lock(paramsMutex);
+    restorePath = path;
+}
+
+void SimulationRunner::publish(double stepsPerSecond){
+    SimSnapshot& snap = snapshots.writeSlot();
+    sim.fillSnapshot(snap);
+    snap.stepsPerSecond = stepsPerSecond;
+    snap.fastForward = false;
+    snap.progress = 0.0f;
+    snapshots.publish();
+}
+
+void SimulationRunner::run(){
+    auto windowStart = chrono::steady_clock::now();
+    auto lastFrame = windowStart;
+    unsigned long windowSteps = 0;
+    double rate = 0.0;
+    RunTarget target;
+    uint64_t targetStart = 0;
+    bool shown = true; // the last published snapshot shows the current state
+    while (!stopFlag){
+        string checkpoint, restore;
+        bool forwarding;
+        {
+            lock_guard<mutex> lock(paramsMutex);
+            if (paramsDirty){
+                sim.getParams() = pendingParams;
+                paramsDirty = false;
+                shown = false;
+            }
+            if (targetDirty){
+                target = pendingTarget;
+                targetStart = sim.getStep();
+                targetDirty = false;
+            }
+            // decided under the lock, so a fastForward() can't land between
+            // latching its target and checking whether the run is over
+            if (fastForwarding && (cancelFastForward || sim.progressTowards(target, targetStart) >= 1.0f)){
+                fastForwarding = false;
+                cancelFastForward = false;
+                pausedFlag = true;
+            }
+            forwarding = fastForwarding;
+            checkpoint.swap(checkpointPath);
+            restore.swap(restorePath);
+        }
+        if (!restore.empty()){
+            CheckpointData data;
+            if (loadCheckpoint(restore.c_str(), data) && sim.restoreCheckpoint(data)){
+                shown = false;
+            }
+        }
+        if (!checkpoint.empty()){
+            CheckpointData data;
+            sim.captureCheckpoint(data);
+            checkpointWriter.write(move(data), checkpoint);
+        }
+        if (pausedFlag){
+            if (!shown){
+                publish(0.0);
+                shown = true;
+            }
+            this_thread::sleep_for(chrono::milliseconds(5));
+            continue;
+        }
+        auto now = chrono::steady_clock::now();
+        bool wanted = snapshots.consumed();
+        if (forwarding){
+            chrono::duration<double> sinceFrame = now - lastFrame;
+            wanted = wanted && sinceFrame.count() >= fastForwardFrameInterval;
+        }
+        SimSnapshot* snap = wanted ? &snapshots.writeSlot() : nullptr;
+        uint64_t remaining = 0;
+        if (forwarding && target.steps > 0){
+            remaining = targetStart + target.steps - sim.getStep();
+        }
+        sim.step(snap, remaining);
+        shown = snap != nullptr;
+        windowSteps++;
+        now = chrono::steady_clock::now();
+        chrono::duration<double> elapsed = now - windowStart;
+        if (elapsed.count() >= 0.5){
+            rate = windowSteps / elapsed.count();
+            windowStart = now;
+            windowSteps = 0;
+        }
+        if (snap){
+            snap->stepsPerSecond = rate;
+            snap->fastForward = forwarding;
+            snap->progress = forwarding ? sim.progressTowards(target, targetStart) : 0.0f;
+            snapshots.publish();
+            lastFrame = now;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef SIM_RUNNER_H
+#define SIM_RUNNER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "checkpoint.h"
+#include "leafsimulation.h"
+#include "snapshot.h"
+
+// Steps a LeafSimulation on its own thread as fast as it can and hands
+// snapshots to the render thread through a triple buffer. A new snapshot
+// is only built once the previous one has been picked up, so a fast
+// simulation doesn't pay for frames nobody draws. While paused, the state
+// is published once and then only again when something changes it.
+class SimulationRunner{
+    private:
+        LeafSimulation& sim;
+        SnapshotBuffer snapshots;
+        std::thread worker;
+        std::atomic<bool> stopFlag{false};
+        std::atomic<bool> pausedFlag{false};
+        std::mutex paramsMutex;
+        SimulationParams pendingParams;
+        bool paramsDirty = false;
+        RunTarget pendingTarget;
+        bool targetDirty = false;
+        std::string checkpointPath; // requested checkpoint, empty if none
+        std::string restorePath;    // checkpoint to load, empty if none
+        CheckpointWriter checkpointWriter;
+        std::atomic<bool> fastForwarding{false};
+        std::atomic<bool> cancelFastForward{false};
+        double fastForwardFrameInterval = 0.25; // seconds between published frames
+        void run();
+        void publish(double stepsPerSecond);
+    public:
+        explicit SimulationRunner(LeafSimulation& s): sim(s){}
+        ~SimulationRunner(){
+            stop();
+        }
+        void start();
+        void stop();
+        void setPaused(bool paused){
+            pausedFlag = paused;
+        }
+        bool isPaused(){
+            return pausedFlag;
+        }
+        // applied by the simulation thread before its next step
+        void updateParams(const SimulationParams& p);
+        // steps towards `target` publishing only a few frames per second,
+        // then pauses
+        void fastForward(const RunTarget& target);
+        // captured between two steps and written in the background
+        void requestCheckpoint(const std::string& path);
+        // loaded and restored between two steps; a file that doesn't load
+        // leaves the simulation as it was
+        void requestRestore(const std::string& path);
+        bool isWritingCheckpoint(){
+            return checkpointWriter.isBusy();
+        }
+        void cancel(){
+            std::lock_guard<std::mutex> lock(paramsMutex);
+            cancelFastForward = true;
+        }
+        bool isFastForwarding(){
+            return fastForwarding;
+        }
+        // render thread: newest published snapshot, never blocks
+        const SimSnapshot& latest(){
+            return snapshots.acquire();
+        }
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Immutable copy of everything the viewer draws or reports for one step.
+struct SimSnapshot{
+    uint64_t step = 0;
+    std::vector<float> margin;   // x, y, z per vertex
+    std::vector<int> marginRings; // first vertex of each closed loop, then the vertex count
+    std::vector<float> sources;  // x, y per source
+    std::vector<float> segments; // x, y, z per endpoint, line list
+    size_t nodeCount = 0;
+    unsigned long samplerRuns = 0;
+    unsigned long samplerSkipped = 0;
+    size_t pendingCandidates = 0;
+    unsigned long mergedIncrements = 0; // growth increments saved by macro-steps
+    unsigned long skippedStages = 0; // venation stage executions with nothing to do
+    double stepsPerSecond = 0.0;
+    bool fastForward = false;
+    float progress = 0.0f; // towards the fast-forward target
+};
+
+// Lock-free triple buffer between one producer and one consumer. The
+// producer always owns a back slot to fill, the consumer always owns a
+// front slot to read, and the third slot is swapped between them through
+// a single atomic, so neither side ever waits for the other.
+class SnapshotBuffer{
+    private:
+        static const int FRESH = 4; // set while the middle slot holds an unread snapshot
+        SimSnapshot slots[3];
+        std::atomic<int> middle{1};
+        int back = 0;
+        int front = 2;
+    public:
+        // producer side
+        SimSnapshot& writeSlot(){
+            return slots[back];
+        }
+        void publish(){
+            back = middle.exchange(back | FRESH) & 3;
+        }
+        // true once the consumer has taken the last published snapshot
+        bool consumed(){
+            return !(middle.load() & FRESH);
+        }
+        // consumer side: swaps in the newest snapshot if there is one
+        const SimSnapshot& acquire(){
+            if (middle.load() & FRESH){
+                front = middle.exchange(front) & 3;
+            }
+            return slots[front];
+        }
+};
+
+#endif
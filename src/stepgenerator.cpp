@@ -0,0 +1,64 @@
+#include "stepgenerator.h"
+
+#include <chrono>
+
+using namespace std;
+
+StepGenerator& StepGenerator::operator=(StepGenerator&& other) noexcept {
+    if (this != &other){
+        if (handle) handle.destroy();
+        handle = other.handle;
+        other.handle = nullptr;
+    }
+    return *this;
+}
+
+bool StepGenerator::next(){
+    if (!handle || handle.done()) return false;
+    handle.resume();
+    if (handle.promise().error) rethrow_exception(handle.promise().error);
+    return !handle.done();
+}
+
+StepGenerator::iterator StepGenerator::begin(){
+    next();
+    return iterator(handle);
+}
+
+StepGenerator stepThrough(LeafSimulation& sim, RunTarget target){
+    bool bounded = target.steps > 0 || target.nodeCount > 0 || target.leafArea > 0.0f;
+    uint64_t start = sim.getStep();
+    vector<float> segments, killed;
+    StepView view;
+    while (!bounded || sim.progressTowards(target, start) < 1.0f){
+        uint64_t remaining = 0;
+        if (target.steps > 0){
+            remaining = start + target.steps - sim.getStep();
+        }
+        uint64_t before = sim.getStep();
+        auto t0 = chrono::steady_clock::now();
+        sim.step(nullptr, remaining);
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - t0;
+
+        segments.clear();
+        for (VeinNode* node : sim.getAddedNodes()){
+            VeinNode* parent = node->getParent();
+            segments.insert(segments.end(), {parent->getX(), parent->getY(), 0.0f,
+                                             node->getX(), node->getY(), 0.0f});
+        }
+        // on the surface, as the snapshot and the export have them
+        const LeafSurface& surface = sim.getSurface();
+        if (!surface.isFlat()){
+            surface.lift(segments);
+        }
+        killed = sim.getKilledSources();
+        view.step = sim.getStep();
+        view.increments = sim.getStep() - before;
+        view.newSegments = segments;
+        view.killedSources = killed;
+        view.nodeCount = sim.nodeCount();
+        view.liveSources = sim.getSources().size();
+        view.millis = elapsed.count();
+        co_yield view;
+    }
+}
\ No newline at end of file
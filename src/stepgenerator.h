@@ -0,0 +1,98 @@
+#ifndef STEP_GENERATOR_H
+#define STEP_GENERATOR_H
+
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <span>
+#include <vector>
+
+#include "leafsimulation.h"
+
+// What one step changed. The spans point into buffers owned by the
+// generator and stay valid until it is resumed.
+struct StepView{
+    uint64_t step = 0;       // step count after the step
+    uint64_t increments = 0; // growth increments it covered
+    std::span<const float> newSegments;   // x, y, z per endpoint, parent then child, z on the leaf surface
+    std::span<const float> killedSources; // x, y per source
+    size_t nodeCount = 0;
+    size_t liveSources = 0;
+    double millis = 0.0;
+};
+
+// Lazily steps a simulation: nothing runs until the consumer asks for the
+// next view, so any number of them can be interleaved on one thread and
+// dropped at any point. Iterate with a range-for or next()/view().
+class StepGenerator{
+    public:
+        struct promise_type{
+            const StepView* current = nullptr;
+            std::exception_ptr error;
+            StepGenerator get_return_object(){
+                return StepGenerator(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            std::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+            std::suspend_always final_suspend() noexcept {
+                return {};
+            }
+            std::suspend_always yield_value(const StepView& v) noexcept {
+                current = &v;
+                return {};
+            }
+            void return_void(){}
+            void unhandled_exception(){
+                error = std::current_exception();
+            }
+        };
+        using Handle = std::coroutine_handle<promise_type>;
+
+        class iterator{
+            private:
+                Handle handle;
+            public:
+                explicit iterator(Handle h = nullptr): handle(h){}
+                const StepView& operator*() const {
+                    return *handle.promise().current;
+                }
+                iterator& operator++(){
+                    handle.resume();
+                    if (handle.promise().error) std::rethrow_exception(handle.promise().error);
+                    return *this;
+                }
+                bool operator==(std::default_sentinel_t) const {
+                    return !handle || handle.done();
+                }
+        };
+
+        StepGenerator(StepGenerator&& other) noexcept: handle(other.handle){
+            other.handle = nullptr;
+        }
+        StepGenerator& operator=(StepGenerator&& other) noexcept;
+        StepGenerator(const StepGenerator&) = delete;
+        StepGenerator& operator=(const StepGenerator&) = delete;
+        ~StepGenerator(){
+            if (handle) handle.destroy();
+        }
+        // runs the next step; false once the target is reached
+        bool next();
+        const StepView& view(){
+            return *handle.promise().current;
+        }
+        iterator begin();
+        std::default_sentinel_t end(){
+            return {};
+        }
+    private:
+        Handle handle;
+        explicit StepGenerator(Handle h): handle(h){}
+};
+
+// Steps `sim` until `target` is reached; a target with no fields set never
+// ends. The simulation must outlive the generator and not be stepped by
+// anyone else meanwhile.
+StepGenerator stepThrough(LeafSimulation& sim, RunTarget target = RunTarget());
+
+#endif
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "superformula.h"
+
+#include <algorithm>
+
+using namespace std;
+
+#define SUPERFORMULA_BATCH 256
+
+// 2x when x is a multiple of 1/2 in (0, 4], else 0
+static int halfSteps(float x){
+    float twice = 2.0f * x;
+    int k = (int)twice;
+    return (k >= 1 && k <= 8 && (float)k == twice) ? k : 0;
+}
+
+static float halfPow(float x, int k, float e){
+    switch (k){
+        case 1: return HalfPow<1>::eval(x);
+        case 2: return HalfPow<2>::eval(x);
+        case 3: return HalfPow<3>::eval(x);
+        case 4: return HalfPow<4>::eval(x);
+        case 5: return HalfPow<5>::eval(x);
+        case 6: return HalfPow<6>::eval(x);
+        case 7: return HalfPow<7>::eval(x);
+        case 8: return HalfPow<8>::eval(x);
+        default: return pow(x, e);
+    }
+}
+
+template <int K>
+static void halfPowPass(float* v, size_t n){
+    for (size_t i = 0; i < n; i++){
+        v[i] = HalfPow<K>::eval(v[i]);
+    }
+}
+
+static void halfPowPass(float* v, size_t n, int k, float e){
+    switch (k){
+        case 1: halfPowPass<1>(v, n); break;
+        case 2: halfPowPass<2>(v, n); break;
+        case 3: halfPowPass<3>(v, n); break;
+        case 4: halfPowPass<4>(v, n); break;
+        case 5: halfPowPass<5>(v, n); break;
+        case 6: halfPowPass<6>(v, n); break;
+        case 7: halfPowPass<7>(v, n); break;
+        case 8: halfPowPass<8>(v, n); break;
+        default:
+            for (size_t i = 0; i < n; i++){
+                v[i] = pow(v[i], e);
+            }
+    }
+}
+
+Superformula::Superformula(float m, float n1, float n2, float n3, float a, float b, float scale){
+    if (!set(m, n1, n2, n3, a, b, scale)){
+        set(2.0f, 1.0f, 1.0f, 1.0f, 2.0f, 1.0f, 20.0f);
+    }
+}
+
+bool Superformula::valid(float m, float n1, float n2, float n3, float a, float b, float scale){
+    for (float v : {m, n1, n2, n3, a, b, scale}){
+        if (!isfinite(v)) return false;
+    }
+    return n1 != 0.0f && a != 0.0f && b != 0.0f;
+}
+
+bool Superformula::set(float pm, float pn1, float pn2, float pn3, float pa, float pb, float pscale){
+    if (!valid(pm, pn1, pn2, pn3, pa, pb, pscale)) return false;
+    m = pm;
+    n1 = pn1;
+    n2 = pn2;
+    n3 = pn3;
+    a = pa;
+    b = pb;
+    scale = pscale;
+    classify();
+    return true;
+}
+
+void Superformula::classify(){
+    k2 = halfSteps(n2);
+    k3 = halfSteps(n3);
+    // (s)^(-1/n1) = 1 / s^(k1/2) with k1 = 2 / n1
+    k1 = n1 > 0.0f ? halfSteps(1.0f / n1) : 0;
+}
+
+float Superformula::operator()(float phi) const {
+    float t = m * phi / 4;
+    float s = halfPow(abs(cos(t) / a), k2, n2) + halfPow(abs(sin(t) / b), k3, n3);
+    float r = k1 ? 1.0f / halfPow(s, k1, 0.0f) : pow(abs(s), -1 / n1);
+    return r * scale;
+}
+
+void Superformula::evaluate(const float* phi, float* r, size_t n) const {
+    float u[SUPERFORMULA_BATCH], v[SUPERFORMULA_BATCH];
+    for (size_t begin = 0; begin < n; begin += SUPERFORMULA_BATCH){
+        size_t count = min<size_t>(SUPERFORMULA_BATCH, n - begin);
+        const float* p = phi + begin;
+        float* out = r + begin;
+        for (size_t i = 0; i < count; i++){
+            float t = m * p[i] / 4;
+            u[i] = abs(cos(t) / a);
+            v[i] = abs(sin(t) / b);
+        }
+        halfPowPass(u, count, k2, n2);
+        halfPowPass(v, count, k3, n3);
+        for (size_t i = 0; i < count; i++){
+            out[i] = u[i] + v[i];
+        }
+        if (k1){
+            halfPowPass(out, count, k1, 0.0f);
+            for (size_t i = 0; i < count; i++){
+                out[i] = 1.0f / out[i] * scale;
+            }
+        }
+        else {
+            for (size_t i = 0; i < count; i++){
+                out[i] = pow(abs(out[i]), -1 / n1) * scale;
+            }
+        }
+    }
+}
\ No newline at end of file
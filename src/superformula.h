@@ -0,0 +1,77 @@
+#ifndef SUPERFORMULA_H
+#define SUPERFORMULA_H
+
+#include <cmath>
+#include <cstddef>
+
+// x^(TwoN / 2) from multiplies and at most one square root
+template <int TwoN>
+struct HalfPow{
+    static float eval(float x){
+        return HalfPow<TwoN - 2>::eval(x) * x;
+    }
+};
+
+template <>
+struct HalfPow<0>{
+    static float eval(float){
+        return 1.0f;
+    }
+};
+
+template <>
+struct HalfPow<1>{
+    static float eval(float x){
+        return std::sqrt(x);
+    }
+};
+
+// Gielis superformula
+//     r(phi) = scale * (|cos(m phi / 4) / a|^n2 + |sin(m phi / 4) / b|^n3)^(-1 / n1)
+// The exponents are checked once when set: n2, n3 and 2 / n1 that are
+// multiples of 1/2 up to 4 are evaluated through HalfPow, anything else
+// falls back to pow. n1, a and b divide, so none of them may be 0.
+class Superformula{
+    private:
+        float m, n1, n2, n3, a, b, scale;
+        int k1, k2, k3; // 2 / n1, 2 n2, 2 n3 when specialised, else 0
+        void classify();
+    public:
+        // parameters that aren't valid() leave the default shape
+        Superformula(float m = 2.0f, float n1 = 1.0f, float n2 = 1.0f, float n3 = 1.0f,
+                     float a = 2.0f, float b = 1.0f, float scale = 20.0f);
+        // false, leaving the formula as it was, unless valid()
+        bool set(float m, float n1, float n2, float n3, float a, float b, float scale);
+        // all finite, and n1, a and b non-zero, as they divide
+        static bool valid(float m, float n1, float n2, float n3, float a, float b, float scale);
+        float operator()(float phi) const;
+        // r[i] = (*this)(phi[i]); the same arithmetic as one at a time,
+        // with the exponent dispatch hoisted out of the loops
+        void evaluate(const float* phi, float* r, size_t n) const;
+        bool isSpecialised() const {
+            return k1 != 0 && k2 != 0 && k3 != 0;
+        }
+        float getM() const {
+            return m;
+        }
+        float getN1() const {
+            return n1;
+        }
+        float getN2() const {
+            return n2;
+        }
+        float getN3() const {
+            return n3;
+        }
+        float getA() const {
+            return a;
+        }
+        float getB() const {
+            return b;
+        }
+        float getScale() const {
+            return scale;
+        }
+};
+
+#endif
\ No newline at end of file
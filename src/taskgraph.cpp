@@ -0,0 +1,87 @@
+#include "taskgraph.h"
+
+#include <chrono>
+
+using namespace std;
+
+int TaskGraph::add(const string& name, function<void()> fn, vector<int> deps){
+    int id = (int)tasks.size();
+    Task t;
+    t.name = name;
+    t.fn = move(fn);
+    t.deps = move(deps);
+    t.pending.reset(new atomic<int>(0));
+    tasks.push_back(move(t));
+    for (int d : tasks[id].deps){
+        tasks[d].successors.push_back(id);
+    }
+    return id;
+}
+
+// time this thread has spent in tasks it picked up while inside the
+// current task, waiting on the pool
+static thread_local double nestedMillis = 0.0;
+
+void TaskGraph::launch(ThreadPool& pool, int id, atomic<size_t>& remaining){
+    pool.submit([this, &pool, id, &remaining]{
+        Task& t = tasks[id];
+        double outer = nestedMillis;
+        nestedMillis = 0.0;
+        auto start = chrono::steady_clock::now();
+        t.fn();
+        chrono::duration<double, milli> spent = chrono::steady_clock::now() - start;
+        t.millis = spent.count() - nestedMillis;
+        nestedMillis = outer + spent.count();
+        for (int s : t.successors){
+            if (--*tasks[s].pending == 0){
+                launch(pool, s, remaining);
+            }
+        }
+        remaining--;
+    });
+}
+
+void TaskGraph::run(ThreadPool& pool){
+    atomic<size_t> remaining(tasks.size());
+    for (Task& t : tasks){
+        *t.pending = (int)t.deps.size();
+    }
+    for (size_t i = 0; i < tasks.size(); i++){
+        if (tasks[i].deps.empty()){
+            launch(pool, (int)i, remaining);
+        }
+    }
+    pool.helpUntil([&remaining]{ return remaining == 0; });
+}
+
+vector<StageTiming> TaskGraph::criticalPath(){
+    vector<double> finish(tasks.size(), 0.0);
+    vector<int> via(tasks.size(), -1);
+    int last = -1;
+    for (size_t i = 0; i < tasks.size(); i++){
+        double start = 0.0;
+        for (int d : tasks[i].deps){
+            if (finish[d] > start){
+                start = finish[d];
+                via[i] = d;
+            }
+        }
+        finish[i] = start + tasks[i].millis;
+        if (last < 0 || finish[i] > finish[last]){
+            last = (int)i;
+        }
+    }
+    vector<StageTiming> path;
+    for (int i = last; i >= 0; i = via[i]){
+        path.insert(path.begin(), {tasks[i].name, tasks[i].millis});
+    }
+    return path;
+}
+
+vector<StageTiming> TaskGraph::timings(){
+    vector<StageTiming> out;
+    for (Task& t : tasks){
+        out.push_back({t.name, t.millis});
+    }
+    return out;
+}
@@ -0,0 +1,47 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "threadpool.h"
+
+struct StageTiming{
+    std::string name;
+    double millis;
+};
+
+// Small DAG of named tasks run on a ThreadPool. A task becomes ready once
+// everything it depends on has finished, so independent branches overlap.
+// Dependencies must refer to tasks added earlier, which keeps ids in
+// topological order.
+class TaskGraph{
+    private:
+        struct Task{
+            std::string name;
+            std::function<void()> fn;
+            std::vector<int> deps;
+            std::vector<int> successors;
+            std::unique_ptr<std::atomic<int>> pending;
+            double millis = 0.0; // in fn, less other tasks it ran while waiting
+        };
+        std::vector<Task> tasks;
+        void launch(ThreadPool& pool, int id, std::atomic<size_t>& remaining);
+    public:
+        int add(const std::string& name, std::function<void()> fn, std::vector<int> deps = {});
+        void run(ThreadPool& pool);
+        void clear(){
+            tasks.clear();
+        }
+        // Most expensive dependency chain of the last run, in execution
+        // order. A task that waits on the pool, as parallelFor() does, runs
+        // other queued work meanwhile; graph tasks it picks up are taken off
+        // its time, but chunks of another task's parallelFor() are not.
+        std::vector<StageTiming> criticalPath();
+        std::vector<StageTiming> timings();
+};
+
+#endif
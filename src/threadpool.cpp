@@ -0,0 +1,126 @@
+#include "threadpool.h"
+
+#include <algorithm>
+
+using namespace std;
+
+// which pool and queue the current thread works for
+static thread_local ThreadPool* workerPool = nullptr;
+static thread_local size_t workerIndex = 0;
+
+ThreadPool::ThreadPool(size_t threads){
+    if (threads == 0){
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threads; i++){
+        queues.emplace_back(new WorkQueue());
+    }
+    for (size_t i = 1; i < threads; i++){
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        lock_guard<mutex> lock(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (thread& t : workers){
+        t.join();
+    }
+}
+
+size_t ThreadPool::currentQueue(){
+    return workerPool == this ? workerIndex : 0;
+}
+
+void ThreadPool::submit(function<void()> task){
+    if (workers.empty()){
+        task();
+        return;
+    }
+    WorkQueue& q = *queues[currentQueue()];
+    {
+        lock_guard<mutex> lock(q.lock);
+        q.tasks.push_back(move(task));
+    }
+    queued++;
+    {
+        lock_guard<mutex> lock(sleepLock);
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::popOwn(size_t self, function<void()>& task){
+    WorkQueue& q = *queues[self];
+    lock_guard<mutex> lock(q.lock);
+    if (q.tasks.empty()) return false;
+    task = move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t self, function<void()>& task){
+    size_t n = queues.size();
+    size_t start = nextQueue++;
+    for (size_t k = 0; k < n; k++){
+        size_t victim = (start + k) % n;
+        if (victim == self) continue;
+        WorkQueue& q = *queues[victim];
+        lock_guard<mutex> lock(q.lock);
+        if (q.tasks.empty()) continue;
+        task = move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::runPending(){
+    if (queued == 0) return false;
+    size_t self = currentQueue();
+    function<void()> task;
+    if (!popOwn(self, task) && !steal(self, task)) return false;
+    queued--;
+    task();
+    return true;
+}
+
+void ThreadPool::helpUntil(const function<bool()>& done){
+    while (!done()){
+        if (!runPending()){
+            this_thread::yield();
+        }
+    }
+}
+
+void ThreadPool::workerLoop(size_t self){
+    workerPool = this;
+    workerIndex = self;
+    while (true){
+        if (runPending()) continue;
+        unique_lock<mutex> lock(sleepLock);
+        wake.wait(lock, [this]{ return stopping || queued > 0; });
+        if (stopping) return;
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const function<void(size_t, size_t, size_t)>& body){
+    grain = max<size_t>(grain, 1);
+    size_t chunks = (count + grain - 1) / grain;
+    if (chunks <= 1 || workers.empty()){
+        for (size_t c = 0; c < chunks; c++){
+            body(c * grain, min(count, (c + 1) * grain), c);
+        }
+        return;
+    }
+    atomic<size_t> remaining(chunks);
+    for (size_t c = 0; c < chunks; c++){
+        submit([&body, &remaining, c, grain, count]{
+            body(c * grain, min(count, (c + 1) * grain), c);
+            remaining--;
+        });
+    }
+    helpUntil([&remaining]{ return remaining == 0; });
+}
@@ -0,0 +1,55 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool. Every worker owns a deque: it pushes and pops its own
+// work at the back and, when that runs dry, steals from the front of the
+// others'. Threads that wait on work (including the caller of
+// parallelFor() and nested waits inside tasks) keep running tasks instead
+// of blocking, so a pool of size 1 has no workers and runs everything
+// inline.
+class ThreadPool{
+    private:
+        struct WorkQueue{
+            std::mutex lock;
+            std::deque<std::function<void()>> tasks;
+        };
+        std::vector<std::thread> workers;
+        std::vector<std::unique_ptr<WorkQueue>> queues; // [0] takes outside submissions
+        std::atomic<size_t> queued{0};
+        std::atomic<size_t> nextQueue{0};
+        std::mutex sleepLock;
+        std::condition_variable wake;
+        bool stopping = false;
+        void workerLoop(size_t self);
+        bool popOwn(size_t self, std::function<void()>& task);
+        bool steal(size_t self, std::function<void()>& task);
+        size_t currentQueue();
+    public:
+        explicit ThreadPool(size_t threads = 0); // 0 = hardware concurrency
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        size_t size(){
+            return workers.size() + 1;
+        }
+        void submit(std::function<void()> task);
+        // runs one queued task if there is any; false when all queues are empty
+        bool runPending();
+        // helps with queued work until `done` becomes true
+        void helpUntil(const std::function<bool()>& done);
+        // body(begin, end, chunk) over [0, count) in chunks of `grain`;
+        // chunk boundaries depend only on count and grain
+        void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t, size_t)>& body);
+};
+
+#endif
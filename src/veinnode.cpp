@@ -1,7 +1,13 @@
 #include "veinnode.h"
 
+#include "leafsurface.h"
+
 using namespace std;
 
+float euclidDistance(float x1, float y1, float x2, float y2){
+    return pow(pow(x1 - x2, 2) + pow(y1 - y2, 2), 0.5);
+}
+
 float euclidDistance(VeinNode* node, float aux_x, float aux_y){
     return euclidDistance(node->getX(), node->getY(), aux_x, aux_y);
 }
@@ -13,22 +19,38 @@ void unitVector(float& x, float& y){
 }
 
 void VeinNode::addNewAuxinSrc(float aux_x, float aux_y){
-    this->auxinSrcs.push_back({aux_x, aux_y});
+    float dir_x = aux_x - this->x;
+    float dir_y = aux_y - this->y;
+    unitVector(dir_x, dir_y);
+    addInfluence(dir_x, dir_y, 1);
 }
 
-void VeinNode::placeNewChildNode(float D){
-    float sum_x = 0.0f, sum_y = 0.0f;
-    for (auto i : auxinSrcs){
-        float aux_x = i.first - this->x;
-        float aux_y = i.second - this->y;
-        unitVector(aux_x, aux_y);
-        sum_x += aux_x;
-        sum_y += aux_y;
-    }
+void VeinNode::addInfluence(float sum_x, float sum_y, int count){
+    influence_x += sum_x;
+    influence_y += sum_y;
+    influenceCount += count;
+}
+
+void VeinNode::clearAuxinSrcs(){
+    influence_x = 0.0f;
+    influence_y = 0.0f;
+    influenceCount = 0;
+}
+
+VeinNode* VeinNode::placeNewChildNode(float D, const LeafSurface* surface){
+    float sum_x = influence_x, sum_y = influence_y;
     unitVector(sum_x, sum_y);
-    VeinNode* newChild = new VeinNode(x + D * sum_x, y + D * sum_y);
+    if (surface){
+        D *= surface->stepScale(x, y, sum_x, sum_y);
+    }
+    return addChild(x + D * sum_x, y + D * sum_y);
+}
+
+VeinNode* VeinNode::addChild(float child_x, float child_y){
+    VeinNode* newChild = new VeinNode(child_x, child_y);
     newChild->parent = this;
     this->children.push_back(newChild);
+    return newChild;
 }
 
 VeinNode* findNearestNode(VeinNode* root, float& aux_x, float& aux_y){
@@ -49,6 +71,24 @@ VeinNode* findNearestNode(VeinNode* root, float& aux_x, float& aux_y){
     return nearestNode;
 }
 
+VeinNode* findNearestNode(VeinNode* root, float aux_x, float aux_y, float aux_z, const LeafSurface& surface){
+    if (!root) return nullptr;
+    if (!root->hasChildren()){
+        return root;
+    }
+    VeinNode* nearestNode = root;
+    float near_dist = surface.distance(aux_x, aux_y, aux_z, root->getX(), root->getY());
+    for (VeinNode* nbr : root->getChildren()){
+        VeinNode* tmp = findNearestNode(nbr, aux_x, aux_y, aux_z, surface);
+        float tmp_dist = surface.distance(aux_x, aux_y, aux_z, tmp->getX(), tmp->getY());
+        if (tmp_dist < near_dist){
+            nearestNode = tmp;
+            near_dist = tmp_dist;
+        }
+    }
+    return nearestNode;
+}
+
 void flattenTree(VeinNode* root, std::vector<float>& nodePos){
     if (!root) return;
     if (!root->hasChildren()){
@@ -65,21 +105,27 @@ void flattenTree(VeinNode* root, std::vector<float>& nodePos){
     }
 }
 
-void placeNewNodes(VeinNode* root, float newNodeDist){
-    if (!root) return;
+size_t placeNewNodes(VeinNode* root, float newNodeDist, vector<VeinNode*>* addedNodes, const LeafSurface* surface){
+    if (!root) return 0;
     if (!root->hasAuxinSrcs() && !root->hasChildren()){
-        return;
+        return 0;
     }
+    size_t added = 0;
     if (root->hasAuxinSrcs()){
-        root->placeNewChildNode(newNodeDist);
-        root->getAuxinSrcs().clear();
+        VeinNode* child = root->placeNewChildNode(newNodeDist, surface);
+        if (addedNodes){
+            addedNodes->push_back(child);
+        }
+        root->clearAuxinSrcs();
+        added++;
     }
     if (!root->hasChildren()){
-        return;
+        return added;
     }
     for (VeinNode* nbr : root->getChildren()){
-        placeNewNodes(nbr, newNodeDist);
+        added += placeNewNodes(nbr, newNodeDist, addedNodes, surface);
     }
+    return added;
 }
 
 bool relativeNeighbourCheck(VeinNode* root, float& vein_x, float& vein_y, float& aux_x, float& aux_y){
@@ -96,4 +142,21 @@ bool relativeNeighbourCheck(VeinNode* root, float& vein_x, float& vein_y, float&
         check &= nbr_check;
     }
     return check;
+}
+
+size_t countNodes(VeinNode* root){
+    if (!root) return 0;
+    size_t count = 1;
+    for (VeinNode* nbr : root->getChildren()){
+        count += countNodes(nbr);
+    }
+    return count;
+}
+
+void deleteTree(VeinNode* root){
+    if (!root) return;
+    for (VeinNode* nbr : root->getChildren()){
+        deleteTree(nbr);
+    }
+    delete root;
 }
\ No newline at end of file
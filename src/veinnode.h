@@ -1,17 +1,24 @@
 #ifndef VEIN_NODE_H
 #define VEIN_NODE_H
 
+#include <cstdint>
 #include <utility>
 #include <vector>
 #include <cmath>
 
+class LeafSurface;
+
 class VeinNode{
     private:
         float x;
         float y;
         VeinNode* parent = nullptr;
+        uint32_t id = 0; // creation order, or preorder after a restore
         std::vector<VeinNode*> children;
-        std::vector<std::pair<float,float>> auxinSrcs;
+        // sum of unit vectors towards the sources influencing this node
+        float influence_x = 0.0f;
+        float influence_y = 0.0f;
+        int influenceCount = 0;
     public:
         explicit VeinNode(float pos_x, float pos_y): x(pos_x), y(pos_y){}
         float getX(){
@@ -20,28 +27,49 @@ class VeinNode{
         float getY(){
             return y;
         }
-        std::vector<VeinNode*> getChildren(){
-            return children;
+        void setPosition(float pos_x, float pos_y){
+            x = pos_x;
+            y = pos_y;
+        }
+        VeinNode* getParent(){
+            return parent;
         }
-        std::vector<std::pair<float,float>> getAuxinSrcs(){
-            return auxinSrcs;
+        uint32_t getId(){
+            return id;
+        }
+        void setId(uint32_t nodeId){
+            id = nodeId;
+        }
+        const std::vector<VeinNode*>& getChildren(){
+            return children;
         }
         bool hasChildren(){
             return !children.empty();
         }
         bool hasAuxinSrcs(){
-            return !auxinSrcs.empty();
+            return influenceCount > 0;
         }
         void addNewAuxinSrc(float aux_x, float aux_y);
-        void placeNewChildNode(float D);
+        // adds `count` sources' worth of already-summed unit directions
+        void addInfluence(float sum_x, float sum_y, int count);
+        void clearAuxinSrcs();
+        // D along the mean direction, measured on `surface` when given
+        VeinNode* placeNewChildNode(float D, const LeafSurface* surface = nullptr);
+        VeinNode* addChild(float child_x, float child_y);
 };
 
 float euclidDistance(float x1, float y1, float x2, float y2);
 float euclidDistance(VeinNode* node, float aux_x, float aux_y);
 void unitVector(float& x, float& y);
 VeinNode* findNearestNode(VeinNode* root, float& aux_x, float& aux_y);
+// nearest by distance over the surface, from a source at height aux_z
+VeinNode* findNearestNode(VeinNode* root, float aux_x, float aux_y, float aux_z, const LeafSurface& surface);
 void flattenTree(VeinNode* root, std::vector<float>& nodePos);
-void placeNewNodes(VeinNode* root, float newNodeDist);
+// returns the number of nodes added; appends them to `added` in placement order
+size_t placeNewNodes(VeinNode* root, float newNodeDist, std::vector<VeinNode*>* added = nullptr,
+                     const LeafSurface* surface = nullptr);
 bool relativeNeighbourCheck(VeinNode* root, float& vein_x, float& vein_y, float& aux_x, float& aux_y);
+size_t countNodes(VeinNode* root);
+void deleteTree(VeinNode* root);
 
 #endif
\ No newline at end of file
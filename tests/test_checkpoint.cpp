@@ -0,0 +1,33 @@
+#include "testutil.h"
+
+#include "checkpoint.h"
+
+// A run resumed from a checkpoint file ends in the same state as one that
+// never stopped.
+int main(){
+    const char* path = "test_checkpoint.ckpt";
+    LeafSimulation straight(testParams());
+    stepTo(straight, 40);
+
+    LeafSimulation first(testParams());
+    stepTo(first, 20);
+    CheckpointData saved;
+    first.captureCheckpoint(saved);
+    CHECK(writeCheckpoint(path, saved));
+
+    CheckpointData loaded;
+    CHECK(loadCheckpoint(path, loaded));
+    LeafSimulation resumed(loaded.params);
+    CHECK(resumed.restoreCheckpoint(loaded));
+    CHECK(resumed.stateHash() == first.stateHash());
+    stepTo(resumed, 40);
+    CHECK(resumed.stateHash() == straight.stateHash());
+    remove(path);
+
+    // a checkpoint that doesn't add up is refused and changes nothing
+    loaded.nodeParent.pop_back();
+    uint64_t before = resumed.stateHash();
+    CHECK(!resumed.restoreCheckpoint(loaded));
+    CHECK(resumed.stateHash() == before);
+    return 0;
+}
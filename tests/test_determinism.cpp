@@ -0,0 +1,19 @@
+#include "testutil.h"
+
+// The state after every step must not depend on the number of worker
+// threads.
+int main(){
+    SimulationParams p = testParams();
+    p.threads = 1;
+    LeafSimulation single(p);
+    p.threads = 4;
+    LeafSimulation pooled(p);
+    while (single.getStep() < 40){
+        single.step();
+        stepTo(pooled, single.getStep());
+        CHECK(single.stateHash() == pooled.stateHash());
+    }
+    CHECK(single.nodeCount() > 1);
+    CHECK(single.nodeCount() == pooled.nodeCount());
+    return 0;
+}
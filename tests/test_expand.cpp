@@ -0,0 +1,49 @@
+#include <cmath>
+
+#include "testutil.h"
+
+// largest distance between b's points and a's scaled by g about the petiole
+template <typename A, typename B>
+static double scaledError(A& a, B& b, size_t n, float px, float py, double g){
+    double err = 0.0;
+    for (size_t i = 0; i < n; i++){
+        err = std::fmax(err, std::fabs(px + g * (a.getX(i) - px) - b.getX(i)));
+        err = std::fmax(err, std::fabs(py + g * (a.getY(i) - py) - b.getY(i)));
+    }
+    return err;
+}
+
+// Expanding the tissue is shrinking unitDist seen at another scale: the
+// expanded leaf is the default one scaled about the petiole by
+// initUnitDist / unitDist, so its margin refines the same way and its
+// first sources land in the same places. The trees themselves part ways,
+// as the vein step is nodeNodeDist in both.
+int main(){
+    SimulationParams p = testParams();
+    LeafSimulation shrink(p);
+    p.expandTissue = true;
+    LeafSimulation expand(p);
+    for (uint64_t s = 1; s <= 40; s++){
+        stepTo(shrink, s);
+        stepTo(expand, s);
+        CHECK(expand.getUnitDist() == p.initUnitDist);
+        double g = p.initUnitDist / shrink.getUnitDist();
+        float px = shrink.getPetiole()->getX(), py = shrink.getPetiole()->getY();
+        CHECK(expand.getPetiole()->getX() == px && expand.getPetiole()->getY() == py);
+        CHECK(std::fabs(expand.leafArea() / shrink.leafArea() - g * g) < 1e-5 * g * g);
+
+        LeafMargin& a = shrink.getLeafMargin();
+        LeafMargin& b = expand.getLeafMargin();
+        CHECK(a.size() == b.size());
+        double extent = b.getXMax() - b.getXMin();
+        CHECK(scaledError(a, b, a.size(), px, py, g) < 1e-5 * extent);
+
+        if (s == 1){
+            AuxinStore& sa = shrink.getSources();
+            AuxinStore& sb = expand.getSources();
+            CHECK(sa.size() > 0 && sa.size() == sb.size());
+            CHECK(scaledError(sa, sb, sa.size(), px, py, g) < 1e-5 * extent);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include <cmath>
+
+#include "testutil.h"
+
+// With a kill distance past the vein step and sources kept well clear of
+// the veins, the leaf runs out of live sources and the sampler soon finds
+// no room: the idle jump then covers the steps until the leaf has grown
+// enough to resample, ending where stepping one at a time does.
+int main(){
+    SimulationParams p = testParams();
+    p.killDist = 3.0f;
+    p.srcNodeDist = 4.0f;
+    p.scheduleAreaFraction = 0.05f;
+    LeafSimulation jumping(p);
+    p.idleJump = false;
+    LeafSimulation stepping(p);
+    stepTo(jumping, 200);
+    stepTo(stepping, 200);
+    StageCounters& c = jumping.getStageCounters();
+    CHECK(c.idleJumps > 0);
+    CHECK(c.jumpedSteps > c.idleJumps);
+    CHECK(stepping.getStageCounters().idleJumps == 0);
+    CHECK(jumping.getStep() == stepping.getStep());
+    CHECK(jumping.nodeCount() == stepping.nodeCount());
+    CHECK(jumping.getSchedule().getRuns() == stepping.getSchedule().getRuns());
+    CHECK(std::fabs(jumping.leafArea() - stepping.leafArea()) < 1e-4f * stepping.leafArea());
+    return 0;
+}
@@ -0,0 +1,27 @@
+#include "macrocheck.h"
+#include "testutil.h"
+
+// With a few live sources still counted as quiet, the controller merges
+// increments once the venation settles. Each macro-step is replayed one
+// increment at a time and may not move the margin, sources or tree by more
+// than the area excess the controller allows, and checking must not change
+// the run it checks.
+int main(){
+    SimulationParams p = testParams();
+    p.idleJump = false;
+    p.macroMaxSteps = 8;
+    p.macroActivityThreshold = 20;
+    LeafSimulation checked(p);
+    LeafSimulation plain(p);
+    std::vector<MacroStepError> errors = checkMacroSteps(checked, 90);
+    stepTo(plain, 90);
+    CHECK(!errors.empty());
+    for (const MacroStepError& e : errors){
+        CHECK(e.increments > 1);
+        CHECK(e.predicted <= p.macroAreaExcess);
+        CHECK(e.worst() <= p.macroAreaExcess);
+    }
+    CHECK(checked.getStep() == 90);
+    CHECK(checked.stateHash() == plain.stateHash());
+    return 0;
+}
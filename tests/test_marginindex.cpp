@@ -0,0 +1,121 @@
+#include <cmath>
+#include <random>
+
+#include "testutil.h"
+
+#include "margin.h"
+
+// brute force over every edge of every ring
+static float nearestEdge(LeafMargin& m, float x, float y){
+    const std::vector<size_t>& rings = m.getRings();
+    float best = INFINITY;
+    for (size_t k = 0; k + 1 < rings.size(); k++){
+        for (size_t i = rings[k]; i < rings[k + 1]; i++){
+            size_t j = i + 1 == rings[k + 1] ? rings[k] : i + 1;
+            float ax = m.getX(i), ay = m.getY(i), ex = m.getX(j) - ax, ey = m.getY(j) - ay;
+            float len2 = ex * ex + ey * ey;
+            float t = len2 > 0.0f ? ((x - ax) * ex + (y - ay) * ey) / len2 : 0.0f;
+            t = std::fmin(std::fmax(t, 0.0f), 1.0f);
+            best = std::fmin(best, std::hypot(ax + t * ex - x, ay + t * ey - y));
+        }
+    }
+    return best;
+}
+
+// even-odd rule per ring, union across rings
+static bool insideRings(LeafMargin& m, float x, float y){
+    const std::vector<size_t>& rings = m.getRings();
+    for (size_t k = 0; k + 1 < rings.size(); k++){
+        bool in = false;
+        for (size_t i = rings[k], j = rings[k + 1] - 1; i < rings[k + 1]; j = i++){
+            float xi = m.getX(i), yi = m.getY(i), xj = m.getX(j), yj = m.getY(j);
+            if ((yi > y) != (yj > y) && x < xi + (y - yi) * (xj - xi) / (yj - yi)){
+                in = !in;
+            }
+        }
+        if (in) return true;
+    }
+    return false;
+}
+
+// 2000 random points around the margin, against the brute-force answers
+static int checkQueries(LeafMargin& margin){
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> ux(margin.getXMin() - 10.0f, margin.getXMax() + 10.0f);
+    std::uniform_real_distribution<float> uy(margin.getYMin() - 10.0f, margin.getYMax() + 10.0f);
+    float tolerance = 1e-6f * (margin.getXMax() - margin.getXMin()) + 1e-3f;
+    for (int q = 0; q < 2000; q++){
+        float x = ux(rng), y = uy(rng);
+        bool in = insideRings(margin, x, y);
+        CHECK(margin.inside(x, y) == in);
+        float d = margin.signedDistance(x, y);
+        CHECK((d < 0.0f) == in);
+        CHECK(std::fabs(std::fabs(d) - nearestEdge(margin, x, y)) < tolerance);
+    }
+    return 0;
+}
+
+// The grid index answers inside and distance queries exactly as a search
+// over every edge does, also after the margin has grown past its grid, and
+// the area counts the lobes' overlap once. Growing through a field while
+// refining, the index files new edges and rescales its grid as it goes
+// instead of being rebuilt, and its cells stay about as full as a fresh
+// index's.
+int main(){
+    std::vector<MarginLobe> lobes(2);
+    lobes[0].shape.set(2, 1, 1, 1, 2, 1, 20);
+    lobes[1].shape.set(2, 1, 1, 1, 2, 1, 10);
+    lobes[1].x = 20.0f;
+    lobes[1].y = 12.0f;
+    lobes[1].rotation = 0.6f;
+    lobes[1].rate = 1.2f;
+    LeafMargin margin;
+    margin.build(lobes, 200);
+    for (int g = 0; g < 30; g++){
+        margin.grow(0.02f, -20.0f, 0.0f);
+    }
+    margin.updateBounds();
+    CHECK(checkQueries(margin) == 0);
+
+    // midpoint rule over a fine grid, against the rings' summed areas
+    const int cells = 600;
+    float x0 = margin.getXMin(), y0 = margin.getYMin();
+    float w = (margin.getXMax() - x0) / cells, h = (margin.getYMax() - y0) / cells;
+    long covered = 0;
+    for (int j = 0; j < cells; j++){
+        for (int i = 0; i < cells; i++){
+            covered += insideRings(margin, x0 + (i + 0.5f) * w, y0 + (j + 0.5f) * h);
+        }
+    }
+    float counted = covered * w * h;
+    LeafMargin first, second;
+    first.build({lobes[0]}, 200);
+    second.build({lobes[1]}, 200);
+    for (int g = 0; g < 30; g++){
+        first.grow(0.02f, -20.0f, 0.0f);
+        second.grow(0.02f, -20.0f, 0.0f);
+    }
+    float area = margin.area();
+    CHECK(std::fabs(area - counted) < 0.005f * counted);
+    CHECK(area < first.area() + second.area());
+
+    LeafMargin field;
+    field.build(lobes, 50);
+    field.updateBounds();
+    GrowthField growth(4, 4);
+    growth.setFunction(baseToTipGrowth(0.5f, 2.0f, 1.5f));
+    size_t vertices = field.size();
+    for (int g = 1; g <= 60; g++){
+        field.grow(growth, 0.03f, -20.0f, 0.0f);
+        field.updateBounds();
+        field.refine(2.0f, 0.0f, 0.0f, -20.0f, 0.0f);
+        if (g % 10 == 0){
+            MarginIndex fresh;
+            fresh.build(field.getXs().data(), field.getYs().data(), field.getRings());
+            CHECK(field.getIndex().maxOccupancy() <= 2 * fresh.maxOccupancy());
+        }
+    }
+    CHECK(field.size() > 8 * vertices);
+    CHECK(checkQueries(field) == 0);
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "testutil.h"
+
+#include "outline.h"
+
+static bool writeFile(const char* path, const std::string& text){
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) return false;
+    fwrite(text.data(), 1, text.size(), file);
+    fclose(file);
+    return true;
+}
+
+static double signedArea(const std::vector<float>& xs, const std::vector<float>& ys){
+    double area = 0.0;
+    for (size_t i = 0, j = xs.size() - 1; i < xs.size(); j = i++){
+        area += (double)xs[j] * ys[i] - (double)xs[i] * ys[j];
+    }
+    return area / 2;
+}
+
+// Relative and smooth path commands land where their absolute spelling
+// does, a closing repeat of the first point is dropped and clockwise
+// outlines come back counter-clockwise, whichever format they are in.
+int main(){
+    // the relative path ends on its start with t, then closes with z; s and
+    // t reflect the previous control points to (10, 15) and (-5, 5)
+    const char* relative = "test_outline_rel.svg";
+    const char* absolute = "test_outline_abs.svg";
+    CHECK(writeFile(relative,
+        "<svg><path class=\"vein d\" data-d=\"M 9 9 L 9 0 Z\"\n"
+        "  d='m 0 0 c 5 0 10 5 10 10 s -5 10 -10 10 q -5 -5 -5 -10 t 5 -10 z m 50 50 l 1 0 l 0 1'/>\n"
+        "<path d=\"M 0 0 L 1 0 L 0 1 Z\"/></svg>\n"));
+    CHECK(writeFile(absolute,
+        "<svg><path d=\"M 0 0 C 5 0 10 5 10 10 C 10 15 5 20 0 20 Q -5 15 -5 10 Q -5 5 0 0 Z\"/></svg>\n"));
+    std::vector<float> xs, ys, ax, ay;
+    CHECK(loadOutline(relative, xs, ys));
+    CHECK(loadOutline(absolute, ax, ay));
+    remove(relative);
+    remove(absolute);
+    // the start and four curves of 16 points, less the closing repeat
+    CHECK(xs.size() == 64);
+    CHECK(xs == ax && ys == ay);
+    CHECK(xs[0] == 0.0f && ys[0] == 0.0f);
+    // y points down in SVG, which makes this outline clockwise once flipped,
+    // so every vertex after the first moved from i to 64 - i
+    CHECK(signedArea(xs, ys) > 0.0);
+    CHECK(std::fabs(xs[40] - 6.875f) < 1e-5f && std::fabs(ys[40] + 16.875f) < 1e-5f); // middle of s
+    CHECK(std::fabs(xs[24] + 3.75f) < 1e-5f && std::fabs(ys[24] + 15.0f) < 1e-5f);    // middle of q
+    CHECK(xs[48] == 10.0f && ys[48] == -10.0f); // the end of c
+    CHECK(xs[32] == 0.0f && ys[32] == -20.0f);  // the end of s
+
+    // text: comments and unparsable lines skipped, any of the separators,
+    // counter-clockwise already, closing repeat dropped
+    const char* text = "test_outline.csv";
+    CHECK(writeFile(text, "# square\nx,y\n0,0\n10,0 # corner\n10 10\n0;10\n0,0\n"));
+    CHECK(loadOutline(text, xs, ys));
+    remove(text);
+    CHECK((xs == std::vector<float>{0, 10, 10, 0}));
+    CHECK((ys == std::vector<float>{0, 0, 10, 10}));
+
+    // binary: the same square clockwise, with its closing repeat
+    const char* binary = "test_outline.bin";
+    const float square[] = {0, 0, 0, 10, 10, 10, 10, 0, 0, 0};
+    CHECK(writeFile(binary, std::string((const char*)square, sizeof(square))));
+    CHECK(loadOutline(binary, xs, ys));
+    remove(binary);
+    CHECK((xs == std::vector<float>{0, 10, 10, 0}));
+    CHECK((ys == std::vector<float>{0, 0, 10, 10}));
+
+    // degenerate outlines are refused
+    const char* line = "test_outline_line.csv";
+    CHECK(writeFile(line, "0,0\n1,1\n2,2\n"));
+    CHECK(!loadOutline(line, xs, ys));
+    CHECK(writeFile(line, "0,0\n1,1\n0,0\n"));
+    CHECK(!loadOutline(line, xs, ys));
+    remove(line);
+    return 0;
+}
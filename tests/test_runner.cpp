@@ -0,0 +1,54 @@
+#include <chrono>
+#include <thread>
+
+#include "testutil.h"
+
+#include "simrunner.h"
+
+// A fast-forward issued while the runner is paused runs exactly to its
+// target and pauses again, however the worker's loop lines up with it. A
+// paused runner publishes its state once, then only after a restore.
+int main(){
+    LeafSimulation sim(testParams());
+    SimulationRunner runner(sim);
+    runner.setPaused(true);
+    runner.start();
+    for (int round = 1; round <= 3; round++){
+        RunTarget target;
+        target.steps = 10;
+        runner.fastForward(target);
+        auto start = std::chrono::steady_clock::now();
+        while (runner.isFastForwarding()){
+            CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(120));
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        CHECK(runner.isPaused());
+        CHECK(sim.getStep() == 10u * round);
+    }
+
+    // the published state catches up, then nothing new arrives
+    auto waitFor = [&](uint64_t step){
+        auto start = std::chrono::steady_clock::now();
+        while (runner.latest().step != step){
+            if (std::chrono::steady_clock::now() - start > std::chrono::seconds(10)) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return true;
+    };
+    CHECK(waitFor(30));
+    const SimSnapshot* shown = &runner.latest();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(&runner.latest() == shown);
+
+    LeafSimulation early(testParams());
+    stepTo(early, 5);
+    CheckpointData saved;
+    early.captureCheckpoint(saved);
+    CHECK(writeCheckpoint("test_runner.ckpt", saved));
+    runner.requestRestore("test_runner.ckpt");
+    CHECK(waitFor(5));
+    CHECK(sim.stateHash() == early.stateHash());
+    runner.stop();
+    remove("test_runner.ckpt");
+    return 0;
+}
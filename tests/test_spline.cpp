@@ -0,0 +1,72 @@
+#include <cmath>
+#include <vector>
+
+#include "testutil.h"
+
+#include "snapshot.h"
+
+// Even-odd inside test and distance for a closed polyline of x, y, z points.
+static float polylineDistance(const std::vector<float>& c, float x, float y, bool& in){
+    size_t n = c.size() / 3;
+    double best = INFINITY;
+    in = false;
+    for (size_t i = 0, j = n - 1; i < n; j = i++){
+        double xi = c[3*i], yi = c[3*i+1], xj = c[3*j], yj = c[3*j+1];
+        if ((yi > y) != (yj > y) && x < (xj - xi) * (y - yi) / (yj - yi) + xi){
+            in = !in;
+        }
+        double ex = xj - xi, ey = yj - yi;
+        double t = ((x - xi) * ex + (y - yi) * ey) / (ex * ex + ey * ey);
+        t = std::fmax(0.0, std::fmin(1.0, t));
+        best = std::fmin(best, std::hypot(x - xi - t * ex, y - yi - t * ey));
+    }
+    return (float)best;
+}
+
+// A spline margin's distances are to the curve itself, matching a dense
+// tessellation of it, while inside() only differs from the tessellation
+// between the curve and its coarse table. How finely the margin is drawn
+// changes the snapshots and nothing the simulation steps through.
+int main(){
+    SimulationParams p = testParams();
+    p.marginControls = 24;
+    LeafSimulation sim(p);
+    stepTo(sim, 60);
+    LeafMargin& margin = sim.getLeafMargin();
+    CHECK(margin.isSpline());
+    std::vector<float> dense;
+    std::vector<int> ringStarts;
+    margin.fillCoords(dense, ringStarts, 256);
+    CHECK(ringStarts.size() == 2);
+    float w = margin.getXMax() - margin.getXMin(), h = margin.getYMax() - margin.getYMin();
+    for (int j = 0; j < 60; j++){
+        for (int i = 0; i < 60; i++){
+            float x = margin.getXMin() + w * (1.2f * (i + 0.5f) / 60 - 0.1f);
+            float y = margin.getYMin() + h * (1.2f * (j + 0.5f) / 60 - 0.1f);
+            bool in;
+            float d = polylineDistance(dense, x, y, in);
+            float sd = margin.signedDistance(x, y);
+            CHECK(std::fabs(std::fabs(sd) - d) < 1e-5f * w + 1e-3f * d);
+            CHECK((sd < 0.0f) == in || d < 1e-5f * w);
+            CHECK(margin.inside(x, y) == in || d < 2e-3f * w);
+        }
+    }
+
+    // drawn at 8 or 64 points per span, with a snapshot every step
+    p.marginControls = 24;
+    p.marginDrawSamples = 8;
+    LeafSimulation coarse(p);
+    p.marginDrawSamples = 64;
+    LeafSimulation fine(p);
+    SimSnapshot a, b;
+    for (int s = 0; s < 40; s++){
+        coarse.step(&a);
+        fine.step(&b);
+        CHECK(coarse.stateHash() == fine.stateHash());
+        CHECK(coarse.getLeafMargin().getSpanSamples() == fine.getLeafMargin().getSpanSamples());
+        CHECK(coarse.getLeafMargin().getIndex().getCols() == fine.getLeafMargin().getIndex().getCols());
+        CHECK(a.segments == b.segments && a.sources == b.sources);
+        CHECK(a.margin.size() == 3 * 24 * 8 && b.margin.size() == 3 * 24 * 64);
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include <cmath>
+
+#include "testutil.h"
+
+#include "stepgenerator.h"
+
+// Pulling steps through a generator is the same as stepping directly, can
+// stop at any point, interleaves with other generators on one thread, and
+// reports new veins on the leaf surface as the snapshot draws them.
+int main(){
+    LeafSimulation direct(testParams());
+    LeafSimulation pulled(testParams());
+    RunTarget target;
+    target.steps = 30;
+    uint64_t increments = 0;
+    for (const StepView& v : stepThrough(pulled, target)){
+        stepTo(direct, v.step);
+        CHECK(pulled.stateHash() == direct.stateHash());
+        CHECK(v.nodeCount == pulled.nodeCount());
+        CHECK(v.newSegments.size() == 6 * pulled.getAddedNodes().size());
+        increments += v.increments;
+    }
+    CHECK(pulled.getStep() == 30);
+    CHECK(increments == 30);
+
+    // dropped after a few steps, the simulation carries on as usual
+    {
+        StepGenerator gen = stepThrough(pulled);
+        for (int k = 0; k < 5; k++){
+            CHECK(gen.next());
+        }
+    }
+    uint64_t stopped = pulled.getStep();
+    CHECK(stopped >= 35);
+    stepTo(pulled, stopped + 5);
+    stepTo(direct, stopped + 5);
+    CHECK(pulled.stateHash() == direct.stateHash());
+
+    // two simulations advanced in turn end where each would alone
+    SimulationParams other = testParams();
+    other.seed = 2;
+    LeafSimulation a(testParams()), b(other), aloneA(testParams()), aloneB(other);
+    target.steps = 20;
+    StepGenerator ga = stepThrough(a, target), gb = stepThrough(b, target);
+    bool moreA = true, moreB = true;
+    while (moreA || moreB){
+        if (moreA) moreA = ga.next();
+        if (moreB) moreB = gb.next();
+    }
+    stepTo(aloneA, 20);
+    stepTo(aloneB, 20);
+    CHECK(a.stateHash() == aloneA.stateHash());
+    CHECK(b.stateHash() == aloneB.stateHash());
+    CHECK(a.stateHash() != b.stateHash());
+
+    // on a curved leaf every new endpoint sits on the surface
+    SimulationParams curved = testParams();
+    curved.surfaceCup = 0.3f;
+    curved.surfaceArch = 0.2f;
+    LeafSimulation leaf(curved);
+    target.steps = 30;
+    size_t lifted = 0;
+    for (const StepView& v : stepThrough(leaf, target)){
+        const LeafSurface& surface = leaf.getSurface();
+        for (size_t i = 0; i < v.newSegments.size(); i += 3){
+            float x = v.newSegments[i], y = v.newSegments[i + 1], z = v.newSegments[i + 2];
+            CHECK(std::fabs(z - surface.height(x, y)) <= 1e-5f * (1.0f + std::fabs(z)));
+            lifted += z != 0.0f;
+        }
+    }
+    CHECK(lifted > 0);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <cmath>
+#include <vector>
+
+#include "testutil.h"
+
+#include "superformula.h"
+
+// the formula as written, through pow in double
+static double reference(const double q[7], double phi){
+    double t = q[0] * phi / 4;
+    double s = std::pow(std::fabs(std::cos(t) / q[4]), q[2]) + std::pow(std::fabs(std::sin(t) / q[5]), q[3]);
+    return q[6] * std::pow(s, -1.0 / q[1]);
+}
+
+// The batched evaluate() gives exactly what operator() does, the HalfPow
+// shortcuts stay within float rounding of pow, and parameters that would
+// divide by zero are refused.
+int main(){
+    const double shapes[][7] = {
+        {2, 1, 1, 1, 2, 1, 20},        // the default, all specialised
+        {5, 2, 6, 6, 1, 1, 10},        // 2 / n1 = 1: a square root
+        {7, 0.5, 1.5, 2.5, 1, 1.5, 3}, // odd half powers
+        {3, 0.7, 1.3, 4.5, 1, 2, 5},   // pow throughout
+        {6, -2, 1, 1, 1, 1, 1},        // negative n1 falls back to pow
+    };
+    std::vector<float> phi(1000), batch(phi.size());
+    for (size_t i = 0; i < phi.size(); i++){
+        phi[i] = 2.0f * (float)M_PI * i / phi.size();
+    }
+    for (const double* q : shapes){
+        Superformula f;
+        CHECK(f.set(q[0], q[1], q[2], q[3], q[4], q[5], q[6]));
+        f.evaluate(phi.data(), batch.data(), phi.size());
+        for (size_t i = 0; i < phi.size(); i++){
+            float one = f(phi[i]);
+            CHECK(batch[i] == one);
+            double r = reference(q, phi[i]);
+            CHECK(std::fabs(one - r) <= 1e-4 * std::fabs(r) + 1e-5);
+        }
+    }
+    CHECK(Superformula(2, 1, 1, 1, 2, 1, 20).isSpecialised());
+    CHECK(!Superformula(3, 0.7f, 1.3f, 4.5f, 1, 2, 5).isSpecialised());
+
+    // zero or non-finite parameters are refused and leave the formula as it was
+    Superformula g(5, 2, 6, 6, 1, 1, 10);
+    CHECK(!g.set(2, 0, 1, 1, 2, 1, 20));
+    CHECK(!g.set(2, 1, 1, 1, 0, 1, 20));
+    CHECK(!g.set(2, 1, 1, 1, 2, 0, 20));
+    CHECK(!g.set(2, 1, NAN, 1, 2, 1, 20));
+    CHECK(!g.set(2, 1, 1, 1, 2, 1, INFINITY));
+    CHECK(g.getM() == 5 && g.getN1() == 2 && g.getScale() == 10);
+    CHECK(std::isfinite(g(0.3f)));
+    Superformula h(2, 0, 1, 1, 2, 1, 20);
+    CHECK(h.getN1() == 1 && h.getA() == 2);
+    CHECK(std::isfinite(h(1.0f)));
+    return 0;
+}
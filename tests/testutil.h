@@ -0,0 +1,32 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <cstdio>
+
+#include "leafsimulation.h"
+
+// Each test is a plain program: CHECK() reports the failed condition and
+// returns 1 from main(), which ctest counts as a failure.
+#define CHECK(cond) \
+    do { \
+        if (!(cond)){ \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            return 1; \
+        } \
+    } while (0)
+
+// a coarse leaf, so the tests stay quick in a debug build
+inline SimulationParams testParams(){
+    SimulationParams p;
+    p.marginResolution = 50;
+    p.threads = 2;
+    return p;
+}
+
+inline void stepTo(LeafSimulation& sim, uint64_t step){
+    while (sim.getStep() < step){
+        sim.step(nullptr, step - sim.getStep());
+    }
+}
+
+#endif